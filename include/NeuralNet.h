@@ -13,31 +13,71 @@
 #include <cmath>
 #include <fstream>
 #include "matrix.h"
+#include "sparseMatrix.h"
+#include "optimizer.h"
+
+/*!
+ * @details Default tile side for pruneInputLayer and PrunedNet, so a net pruned and converted with defaults stores few tiles.
+ */
+const int defaultPruneBlock = 4;
 
 class NeuralNet
 {
 public:
     NeuralNet(int inputNodes, int hiddenNodes, int outputNodes);
+    NeuralNet(const Matrix<double>& weightsInputHidden, const Matrix<double>& weightsHiddenOutput,
+              const Matrix<double>& hiddenBias, const Matrix<double>& outputBias);
+    NeuralNet(const NeuralNet& other);
+    NeuralNet(NeuralNet&& other) = default;
+    NeuralNet& operator=(const NeuralNet& other);
+    NeuralNet& operator=(NeuralNet&& other) = default;
     void train(Matrix<double>& input,
                Matrix<double>& targets);
-    Matrix<double> predict(Matrix<double>& input);
-    void setLearningRate(int newRate);
-    double getLearningRate(){return learningRate;}
+    Matrix<double> predict(const Matrix<double>& input) const;
+    int getInputNodes() const {return input_nodes;}
+    int getHiddenNodes() const {return hidden_nodes;}
+    int getOutputNodes() const {return output_nodes;}
+    void setLearningRate(double newRate);
+    double getLearningRate(){return optimizer->getLearningRate();}
+    void setOptimizer(std::shared_ptr<Optimizer> newOptimizer);
+    std::shared_ptr<Optimizer> getOptimizer(){return optimizer;}
     Matrix<double> feedForward(const Matrix<double>& input);
+    Matrix<double> feedForward(const SparseMatrix<double>& input);
     static std::function<double (double)> returnSigmoidFunction();
     static std::function<double (double)> returnDsigmoidFunction();
     void learn(Matrix<double>& a, Matrix<double>& b);
+    void learn(const SparseMatrix<double>& a, Matrix<double>& b);
+    void pruneInputLayer(double sparsity, int blockRows = defaultPruneBlock, int blockCols = defaultPruneBlock);
+    void pruneInputLayerThreshold(double threshold, int blockRows = defaultPruneBlock, int blockCols = defaultPruneBlock);
+    void clearPruningMask(){inputHiddenMask = Matrix<double>();}
+    int getPruneBlockRows() const {return pruneBlockRows;}
+    int getPruneBlockCols() const {return pruneBlockCols;}
+    const Matrix<double>& getWeightsInputHidden() const {return weights_input_hidden;}
+    const Matrix<double>& getWeightsHiddenOutput() const {return weights_hidden_output;}
+    const Matrix<double>& getBiasHidden() const {return biasHidden;}
+    const Matrix<double>& getBiasOutput() const {return biasOutput;}
+    void setSparseDensityThreshold(double threshold){sparseDensityThreshold = threshold;}
+    double getSparseDensityThreshold(){return sparseDensityThreshold;}
     void loadModel(std::string fileName);
     void saveModel();
 private:
+    Matrix<double> feedForwardHidden(Matrix<double> hiddenSum);
+    void applyPruningMask();
+    void applyPruningMask(const std::vector<int>& rows);
+    void backpropagate(Matrix<double> hiddenSum, Matrix<double>& outputs,
+                       Matrix<double>& DJdb1, Matrix<double>& DJdb2, Matrix<double>& DJdw2);
     int input_nodes;
     int hidden_nodes;
     int output_nodes;
-    double learningRate;
+    std::shared_ptr<Optimizer> optimizer; /*!< Applies the gradients, every copy of the net gets its own clone */
+    double sparseDensityThreshold; /*!< Sparse inputs denser than this take the dense path */
     Matrix<double> biasHidden;
     Matrix<double> biasOutput;
     Matrix<double> weights_input_hidden;
     Matrix<double> weights_hidden_output;
+    Matrix<double> inputHiddenMask; /*!< 0/1 mask kept after pruning, empty when the input layer is dense */
+    int pruneBlockRows; /*!< Tile shape of the last pruning, defaultPruneBlock before any */
+    int pruneBlockCols;
     Matrix<double> Y;
     Matrix<double> H;
 };
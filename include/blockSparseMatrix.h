@@ -0,0 +1,296 @@
+//
+//  blockSparseMatrix.h
+//  Neural Net
+//
+//  Block compressed sparse row Matrix, used for pruned weight matrices.
+//
+
+#ifndef blockSparseMatrix_h
+#define blockSparseMatrix_h
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "matrix.h"
+
+/*!
+ * @details Matrix stored in block compressed sparse row (BSR) form. The Matrix is cut into blockRows x blockCols tiles and
+ * only tiles holding a non zero are kept, each as a dense row major tile. Tiles on the right and bottom edge may stick out
+ * past the Matrix, the part outside is zero and never read back. Block row i owns the tiles blockStart[i] to
+ * blockStart[i + 1].
+ * @tparam T
+ */
+template <class T>
+class BlockSparseMatrix
+{
+public:
+    BlockSparseMatrix();
+    static BlockSparseMatrix<T> fromDense(const Matrix<T>& a, int blockRows, int blockCols);
+    Matrix<T> toDense() const;
+    static Matrix<T> dot(const Matrix<T>& a, const BlockSparseMatrix<T>& b);
+
+    void save(std::ostream& stream) const;
+    static BlockSparseMatrix<T> load(std::istream& stream);
+
+    int getRows()const{return rows;}
+    int getColumns()const{return columns;}
+    int getBlockRows()const{return blockRows;}
+    int getBlockCols()const{return blockCols;}
+    int storedBlocks()const{return static_cast<int>(blockColumn.size());}
+    double density()const;
+private:
+    template <typename V>
+    static void readArray(std::istream& stream, V& array, std::size_t count);
+
+    int rows; /*!< Matrix rows */
+
+    int columns; /*!< Matrix columns */
+
+    int blockRows; /*!< Rows per tile */
+
+    int blockCols; /*!< Columns per tile */
+
+    std::vector<int> blockStart; /*!< First tile of each block row, one entry per block row plus one */
+
+    std::vector<int> blockColumn; /*!< Block column of each stored tile */
+
+    std::vector<T, PlacementAllocator<T> > values; /*!< Tiles back to back, blockRows * blockCols values each */
+};
+/*!
+ * @details Empty 0x0 Matrix with 1x1 tiles.
+ */
+template <typename T>
+BlockSparseMatrix<T>::BlockSparseMatrix()
+{
+    this->rows = 0;
+    this->columns = 0;
+    this->blockRows = 1;
+    this->blockCols = 1;
+    this->blockStart.push_back(0);
+}
+/*!
+ * @details Compresses a dense Matrix, keeping only tiles with at least one non zero. Throws std::invalid_argument if a tile
+ * dimension is not positive.
+ * @param a
+ * @param blockRows
+ * @param blockCols
+ * @return BlockSparseMatrix object of type T.
+ */
+template <typename T>
+BlockSparseMatrix<T> BlockSparseMatrix<T>::fromDense(const Matrix<T>& a, int blockRows, int blockCols)
+{
+    if(blockRows <= 0 || blockCols <= 0) throw std::invalid_argument("Block dims must be positive");
+    BlockSparseMatrix<T> result;
+    result.rows = a.getRows();
+    result.columns = a.getColumns();
+    result.blockRows = blockRows;
+    result.blockCols = blockCols;
+    const int tileSize = blockRows * blockCols;
+    for(int r0 = 0; r0 < result.rows; r0 += blockRows)
+    {
+        const int rEnd = std::min(r0 + blockRows, result.rows);
+        for(int c0 = 0; c0 < result.columns; c0 += blockCols)
+        {
+            const int cEnd = std::min(c0 + blockCols, result.columns);
+            bool nonZero = false;
+            for(int i = r0; i < rEnd && !nonZero; i++)
+            {
+                const T* row = a.rowPointer(i);
+                for(int j = c0; j < cEnd; j++)
+                {
+                    if(row[j] != T(0))
+                    {
+                        nonZero = true;
+                        break;
+                    }
+                }
+            }
+            if(!nonZero) continue;
+            result.blockColumn.push_back(c0 / blockCols);
+            result.values.resize(result.values.size() + tileSize, T(0));
+            T* tile = result.values.data() + result.values.size() - tileSize;
+            for(int i = r0; i < rEnd; i++)
+            {
+                const T* row = a.rowPointer(i);
+                for(int j = c0; j < cEnd; j++)
+                {
+                    tile[(i - r0) * blockCols + (j - c0)] = row[j];
+                }
+            }
+        }
+        result.blockStart.push_back(static_cast<int>(result.blockColumn.size()));
+    }
+    return result;
+}
+/*!
+ * @details Expands into a dense Matrix.
+ * @return Matrix object of type T.
+ */
+template <typename T>
+Matrix<T> BlockSparseMatrix<T>::toDense() const
+{
+    Matrix<T> result(this->rows, this->columns);
+    const int tileSize = this->blockRows * this->blockCols;
+    for(int br = 0; br + 1 < static_cast<int>(this->blockStart.size()); br++)
+    {
+        const int r0 = br * this->blockRows;
+        const int rEnd = std::min(r0 + this->blockRows, this->rows);
+        for(int p = this->blockStart[br]; p < this->blockStart[br + 1]; p++)
+        {
+            const int c0 = this->blockColumn[p] * this->blockCols;
+            const int cEnd = std::min(c0 + this->blockCols, this->columns);
+            const T* tile = this->values.data() + static_cast<std::size_t>(p) * tileSize;
+            for(int i = r0; i < rEnd; i++)
+            {
+                T* row = result.rowPointer(i);
+                for(int j = c0; j < cEnd; j++)
+                {
+                    row[j] = tile[(i - r0) * this->blockCols + (j - c0)];
+                }
+            }
+        }
+    }
+    return result;
+}
+/*!
+ * @details Dense activation times sparse weight product a * b. Only stored tiles are visited, and within a tile zero
+ * activations are skipped. Throws std::invalid_argument if the dims cannot be multiplied.
+ * @param a batch of activations, one sample per row
+ * @param b
+ * @return Matrix object of type T.
+ */
+template <typename T>
+Matrix<T> BlockSparseMatrix<T>::dot(const Matrix<T>& a, const BlockSparseMatrix<T>& b)
+{
+    if(a.getColumns() != b.rows)
+    {
+        throw std::invalid_argument("Matrix dims cannot be multiplied");
+    }
+    Matrix<T> result(a.getRows(), b.columns);
+    const int tileSize = b.blockRows * b.blockCols;
+    for(int s = 0; s < a.getRows(); s++)
+    {
+        const T* aRow = a.rowPointer(s);
+        T* cRow = result.rowPointer(s);
+        for(int br = 0; br + 1 < static_cast<int>(b.blockStart.size()); br++)
+        {
+            const int r0 = br * b.blockRows;
+            const int rCount = std::min(b.blockRows, b.rows - r0);
+            for(int p = b.blockStart[br]; p < b.blockStart[br + 1]; p++)
+            {
+                const int c0 = b.blockColumn[p] * b.blockCols;
+                const int cCount = std::min(b.blockCols, b.columns - c0);
+                const T* tile = b.values.data() + static_cast<std::size_t>(p) * tileSize;
+                for(int i = 0; i < rCount; i++)
+                {
+                    const T value = aRow[r0 + i];
+                    if(value == T(0)) continue;
+                    const T* tileRow = tile + i * b.blockCols;
+                    for(int j = 0; j < cCount; j++)
+                    {
+                        cRow[c0 + j] += value * tileRow[j];
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+/*!
+ * @details Writes the Matrix in native byte order, the size is proportional to the stored tiles.
+ * @param stream binary stream
+ */
+template <typename T>
+void BlockSparseMatrix<T>::save(std::ostream& stream) const
+{
+    //TODO: Account for little endian and big endian machines
+    int header[5] = {this->rows, this->columns, this->blockRows, this->blockCols, storedBlocks()};
+    stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(this->blockStart.data()), this->blockStart.size() * sizeof(int));
+    stream.write(reinterpret_cast<const char*>(this->blockColumn.data()), this->blockColumn.size() * sizeof(int));
+    stream.write(reinterpret_cast<const char*>(this->values.data()), this->values.size() * sizeof(T));
+}
+/*!
+ * @details Reads a Matrix written by save, throws std::runtime_error if the stream ends early, holds invalid dims, more
+ * tiles than the Matrix has room for, more than INT_MAX values, or its tile offsets or block columns point outside the
+ * Matrix. The header is checked before any buffer is sized from it.
+ * @param stream binary stream
+ * @return BlockSparseMatrix object of type T.
+ */
+template <typename T>
+BlockSparseMatrix<T> BlockSparseMatrix<T>::load(std::istream& stream)
+{
+    int header[5];
+    stream.read(reinterpret_cast<char*>(header), sizeof(header));
+    if(!stream || header[0] < 0 || header[1] < 0 || header[2] <= 0 || header[3] <= 0 || header[4] < 0)
+    {
+        throw std::runtime_error("Invalid block sparse Matrix data");
+    }
+    // checked before anything is allocated, the header alone must not be able to ask for more than the Matrix holds
+    const long long blockRowCount = (static_cast<long long>(header[0]) + header[2] - 1) / header[2];
+    const long long blockColCount = (static_cast<long long>(header[1]) + header[3] - 1) / header[3];
+    const long long tileSize = static_cast<long long>(header[2]) * header[3];
+    if(tileSize > std::numeric_limits<int>::max() || header[4] > blockRowCount * blockColCount ||
+       header[4] * tileSize > static_cast<long long>(std::numeric_limits<int>::max()))
+    {
+        throw std::runtime_error("Invalid block sparse Matrix data");
+    }
+    BlockSparseMatrix<T> result;
+    result.rows = header[0];
+    result.columns = header[1];
+    result.blockRows = header[2];
+    result.blockCols = header[3];
+    readArray(stream, result.blockStart, static_cast<std::size_t>(blockRowCount) + 1);
+    readArray(stream, result.blockColumn, header[4]);
+    readArray(stream, result.values, static_cast<std::size_t>(header[4] * tileSize));
+    if(result.blockStart.front() != 0 || result.blockStart.back() != header[4])
+    {
+        throw std::runtime_error("Invalid block sparse Matrix data");
+    }
+    // dot and toDense index with these without checks
+    for(std::size_t br = 1; br < result.blockStart.size(); br++)
+    {
+        if(result.blockStart[br] < result.blockStart[br - 1]) throw std::runtime_error("Invalid block sparse Matrix data");
+    }
+    for(int column : result.blockColumn)
+    {
+        if(column < 0 || column >= blockColCount) throw std::runtime_error("Invalid block sparse Matrix data");
+    }
+    return result;
+}
+/*!
+ * @details Reads count values into array, throws std::runtime_error if the stream ends early. The array grows with the
+ * data actually read, so a truncated stream with a large header does not allocate the full size first.
+ * @param stream binary stream
+ * @param array vector of the stored type
+ * @param count values to read
+ */
+template <typename T>
+template <typename V>
+void BlockSparseMatrix<T>::readArray(std::istream& stream, V& array, std::size_t count)
+{
+    const std::size_t chunk = 1 << 16;
+    array.clear();
+    while(array.size() < count)
+    {
+        const std::size_t offset = array.size();
+        const std::size_t length = std::min(chunk, count - offset);
+        array.resize(offset + length);
+        stream.read(reinterpret_cast<char*>(array.data() + offset), length * sizeof(typename V::value_type));
+        if(!stream) throw std::runtime_error("Invalid block sparse Matrix data");
+    }
+}
+/*!
+ * @details Fraction of the Matrix covered by stored tiles, 0 for an empty Matrix.
+ * @return double between 0 and 1.
+ */
+template <typename T>
+double BlockSparseMatrix<T>::density() const
+{
+    double total = static_cast<double>(this->rows) * this->columns;
+    return total == 0 ? 0 : std::min(1.0, this->values.size() / total);
+}
+
+#endif /* blockSparseMatrix_h */
@@ -9,20 +9,31 @@
 #ifndef dataParser_h
 #define dataParser_h
 #include "matrix.h"
+#include "sparseMatrix.h"
 #include <iostream>
 #include <fstream>
+#include <stdexcept>
 #include <vector>
 
+const int imagesPerFile = 1000; /*!< Digits in each data file */
+const int pixelsPerImage = 784; /*!< 28x28 pixels, one byte each */
+
 double normalizePixelData(unsigned char i)
 {
     return static_cast<double>(i) / 255;
 }
 /*
- *  Read in data stored as unsigned char (1 Byte), each files consists of 28x28 digits back to back
+ *  Raw file contents, placed by the current MemoryPolicy like Matrix storage
+ */
+typedef std::vector<unsigned char, PlacementAllocator<unsigned char> > ByteBuffer;
+/*
+ *  Read in data stored as unsigned char (1 Byte), each files consists of 28x28 digits back to back. Throws
+ *  std::runtime_error if the file cannot be opened.
  */
-std::vector<unsigned char> readData(std::string fileName)
+ByteBuffer readData(std::string fileName)
 {
     std::ifstream file(fileName,std::ios::binary);
+    if(!file) throw std::runtime_error("Could not open " + fileName);
     file.unsetf(std::ios::skipws);
 
     std::streampos fileSize;
@@ -32,7 +43,7 @@ std::vector<unsigned char> readData(std::string fileName)
     file.seekg(0, std::ios::beg);
 
 
-    std::vector<unsigned char> vec;
+    ByteBuffer vec;
     vec.reserve(fileSize);
     vec.insert(vec.begin(),
                std::istream_iterator<unsigned char>(file),
@@ -40,21 +51,34 @@ std::vector<unsigned char> readData(std::string fileName)
     return vec;
 
 }
+/*
+ *  Reads a data file and checks it holds exactly imagesPerFile digits, so the dense and sparse loaders always see the same
+ *  samples. Throws std::runtime_error on a missing, short or misaligned file.
+ */
+ByteBuffer readDigitData(std::string fileName)
+{
+    ByteBuffer data = readData(fileName);
+    if(data.size() != static_cast<std::size_t>(imagesPerFile) * pixelsPerImage)
+    {
+        throw std::runtime_error(fileName + " does not hold " + std::to_string(imagesPerFile) + " digits");
+    }
+    return data;
+}
 /*
  *  Each file has 1000 training examples, loop through each and store in 2d array
  */
 Matrix<double> returnMatrixData(std::string fileName)
 {
-   Matrix<double> tempMat(1000,784);
-   std::vector<unsigned char> data = readData(fileName);
+   Matrix<double> tempMat(imagesPerFile,pixelsPerImage);
+   ByteBuffer data = readDigitData(fileName);
    //std::vector<std::vector<double> > temp;
    std::vector<double> pixelData;
-   pixelData.reserve(784);
+   pixelData.reserve(pixelsPerImage);
    int k = 0;
    int j = 0;
    for(int i = 0; i < static_cast<int>(data.size()); i++)
    {
-       if(k == 784)
+       if(k == pixelsPerImage)
        {
            //temp.push_back(pixelData);
            pixelData.clear();
@@ -66,6 +90,31 @@ Matrix<double> returnMatrixData(std::string fileName)
    }
    return tempMat;
 
+}
+/*
+ *  Same as returnMatrixData, but keeps only the non zero pixels. Most pixels of a digit are background, so this is
+ *  several times smaller and lets the first layer skip the zero inputs.
+ */
+SparseMatrix<double> returnSparseMatrixData(std::string fileName)
+{
+   SparseMatrix<double> tempMat(imagesPerFile,pixelsPerImage);
+   ByteBuffer data = readDigitData(fileName);
+   int k = 0;
+   for(int i = 0; i < static_cast<int>(data.size()); i++)
+   {
+       if(data[i] != 0)
+       {
+           tempMat.pushBack(k, normalizePixelData(data[i]));
+       }
+       k++;
+       if(k == pixelsPerImage)
+       {
+           tempMat.endRow();
+           k = 0;
+       }
+   }
+   return tempMat;
+
 }
 
 #endif /* dataParser_h */
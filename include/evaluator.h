@@ -0,0 +1,60 @@
+//
+//  evaluator.h
+//  Neural Net
+//
+//  Batched, multi threaded evaluation of a NeuralNet on a labelled data set.
+//
+
+#ifndef evaluator_h
+#define evaluator_h
+
+#include <future>
+#include <iostream>
+#include <vector>
+#include "matrix.h"
+#include "NeuralNet.h"
+#include "prunedNet.h"
+
+/*!
+ * @details Result of an evaluation. confusion[actual][predicted] counts samples, latencies are per batch in milliseconds.
+ */
+struct EvaluationReport
+{
+    int samples;
+    int classes;
+    double accuracy;
+    double loss; /*!< Mean over samples of the squared error against the one hot label */
+    std::vector<double> precision;
+    std::vector<double> recall;
+    std::vector<std::vector<int> > confusion;
+    double imagesPerSecond;
+    double latencyP50;
+    double latencyP90;
+    double latencyP99;
+
+    friend std::ostream& operator<<(std::ostream& stream, const EvaluationReport& report);
+};
+
+/*!
+ * @details Runs a data set through the predict method of a NeuralNet or PrunedNet in batches of batchSize rows, spread
+ * over worker threads. Labels are class indices, the predicted class of a sample is the argmax of its output row.
+ */
+class Evaluator
+{
+public:
+    explicit Evaluator(int batchSize = 64, int threads = 0);
+    EvaluationReport evaluate(const NeuralNet& net, const Matrix<double>& inputs, const std::vector<int>& labels) const;
+    EvaluationReport evaluate(const PrunedNet& net, const Matrix<double>& inputs, const std::vector<int>& labels) const;
+    std::future<EvaluationReport> evaluateAsync(const NeuralNet& net, const Matrix<double>& inputs,
+                                                const std::vector<int>& labels) const;
+    static int argmax(const Matrix<double>& outputs, int row);
+    int getBatchSize() const {return batchSize;}
+    int getThreads() const {return threads;}
+private:
+    EvaluationReport evaluatePredictor(const std::function<Matrix<double> (const Matrix<double>&)>& predict, int inputNodes,
+                                       int classes, const Matrix<double>& inputs, const std::vector<int>& labels) const;
+    int batchSize;
+    int threads; /*!< Worker threads, 0 uses std::thread::hardware_concurrency */
+};
+
+#endif /* evaluator_h */
@@ -0,0 +1,342 @@
+//
+//  fixedMatrix.h
+//  Neural Net
+//
+//  Compile time fixed shape Matrix.
+//
+
+#ifndef fixedMatrix_h
+#define fixedMatrix_h
+
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include "matrix.h"
+
+/*!
+ * @details Alignment of the storage of every fixed shape Matrix.
+ */
+const std::size_t fixedMatrixAlignment = 32;
+
+/*!
+ * @details Matrix with dimensions known at compile time. Elements live inline in the object, so a fixed Matrix declared on
+ * the stack or as a static never touches the heap, and all loops have constant trip counts that the compiler can unroll
+ * and vectorize. Shapes are checked by the type system, so element access does no runtime validation. Converts to and
+ * from the runtime sized Matrix<T>.
+ * @tparam T
+ * @tparam Rows
+ * @tparam Cols
+ */
+template <class T, int Rows, int Cols>
+class Matrix
+{
+    static_assert(Rows > 0 && Cols > 0, "Fixed Matrix dims must be positive");
+public:
+    Matrix();
+    explicit Matrix(const Matrix<T>& a);
+    Matrix<T> toDynamic() const;
+
+    template <int K>
+    static Matrix<T, Rows, Cols> dot(const Matrix<T, Rows, K>& a, const Matrix<T, K, Cols>& b);
+    template <int K>
+    static Matrix<T, Rows, Cols> dotTransposeA(const Matrix<T, K, Rows>& a, const Matrix<T, K, Cols>& b);
+    template <int K>
+    static Matrix<T, Rows, Cols> dotTransposeB(const Matrix<T, Rows, K>& a, const Matrix<T, Cols, K>& b);
+    static Matrix<T, Rows, Cols> subtract(const Matrix<T, Rows, Cols>& a, const Matrix<T, Rows, Cols>& b);
+    static Matrix<T, Cols, Rows> transpose(const Matrix<T, Rows, Cols>& a);
+
+    template <class Func>
+    void map(Func func);
+    static constexpr int getRows(){return Rows;}
+    static constexpr int getColumns(){return Cols;}
+    void elementWiseMultiplyMatrix(const Matrix<T, Rows, Cols>& a);
+    void elementWiseMulitpyScalar(T n);
+    void elementWiseAddMatrix(const Matrix<T, Rows, Cols>& a);
+    void elementWiseAddScalar(T n);
+    void randomize();
+    void xavierUniform();
+    void set(int row, int column, T newVal){internalMatrix[row * Cols + column] = newVal;}
+    /*!
+     * @details Returns the value of the Matrix at index i,j. Indices are not validated.
+     * @param row
+     * @param col
+     * @return Value of type T.
+     */
+    T operator()(int row, int col)const{return internalMatrix[row * Cols + col];}
+    T& operator()(int row, int col){return internalMatrix[row * Cols + col];}
+
+    /*!
+     * @details new and new[] honor fixedMatrixAlignment, which plain operator new does not guarantee before C++17.
+     * std::allocator and std::make_shared do not go through these, so before C++17 a fixed Matrix held in a std::vector
+     * or a shared_ptr may be misaligned. Create those with new or new[] instead.
+     */
+    static void* operator new(std::size_t size)
+    {
+        void* memory = nullptr;
+        if(posix_memalign(&memory, fixedMatrixAlignment, size) != 0) throw std::bad_alloc();
+        return memory;
+    }
+    static void* operator new[](std::size_t size){return operator new(size);}
+    static void operator delete(void* memory){std::free(memory);}
+    static void operator delete[](void* memory){std::free(memory);}
+
+    friend std::ostream& operator<<(std::ostream& stream, const Matrix<T, Rows, Cols>& a)
+    {
+        for(int i = 0; i < Rows; i++)
+        {
+            for(int j = 0; j < Cols; j++)
+            {
+                stream << a(i,j) << " ";
+            }
+            stream << std::endl;
+        }
+        return stream;
+    }
+
+private:
+    void randomizeUniform(T low, T high);
+
+    alignas(fixedMatrixAlignment) T internalMatrix[Rows * Cols]; /*!< Row major storage */
+};
+/*!
+ * @details Default constructor, every element starts at 0.
+ */
+template <class T, int Rows, int Cols>
+Matrix<T, Rows, Cols>::Matrix()
+{
+    for(int i = 0; i < Rows * Cols; i++)
+    {
+        internalMatrix[i] = 0;
+    }
+}
+/*!
+ * @details Copies a runtime sized Matrix, throws std::invalid_argument if its dims differ from Rows x Cols.
+ * @param a
+ */
+template <class T, int Rows, int Cols>
+Matrix<T, Rows, Cols>::Matrix(const Matrix<T>& a)
+{
+    if(a.getRows() != Rows || a.getColumns() != Cols)
+    {
+        throw std::invalid_argument("Matrix dims do not match fixed shape");
+    }
+    for(int i = 0; i < Rows; i++)
+    {
+        const T* row = a.rowPointer(i);
+        for(int j = 0; j < Cols; j++)
+        {
+            internalMatrix[i * Cols + j] = row[j];
+        }
+    }
+}
+/*!
+ * @details Copies this Matrix into a runtime sized Matrix.
+ * @return Matrix object of type T.
+ */
+template <class T, int Rows, int Cols>
+Matrix<T> Matrix<T, Rows, Cols>::toDynamic() const
+{
+    Matrix<T> result(Rows, Cols);
+    for(int i = 0; i < Rows; i++)
+    {
+        T* row = result.rowPointer(i);
+        for(int j = 0; j < Cols; j++)
+        {
+            row[j] = internalMatrix[i * Cols + j];
+        }
+    }
+    return result;
+}
+/*!
+ * @details Computes a * b. The inner dimension K is deduced, mismatched shapes fail to compile.
+ * @return Matrix object of shape Rows x Cols.
+ */
+template <class T, int Rows, int Cols>
+template <int K>
+Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::dot(const Matrix<T, Rows, K>& a, const Matrix<T, K, Cols>& b)
+{
+    Matrix<T, Rows, Cols> result;
+    for(int i = 0; i < Rows; i++)
+    {
+        for(int k = 0; k < K; k++)
+        {
+            const T aik = a(i,k);
+            for(int j = 0; j < Cols; j++)
+            {
+                result(i,j) += aik * b(k,j);
+            }
+        }
+    }
+    return result;
+}
+/*!
+ * @details Computes transpose(a) * b without building the transpose.
+ * @return Matrix object of shape Rows x Cols.
+ */
+template <class T, int Rows, int Cols>
+template <int K>
+Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::dotTransposeA(const Matrix<T, K, Rows>& a, const Matrix<T, K, Cols>& b)
+{
+    Matrix<T, Rows, Cols> result;
+    for(int k = 0; k < K; k++)
+    {
+        for(int i = 0; i < Rows; i++)
+        {
+            const T aki = a(k,i);
+            for(int j = 0; j < Cols; j++)
+            {
+                result(i,j) += aki * b(k,j);
+            }
+        }
+    }
+    return result;
+}
+/*!
+ * @details Computes a * transpose(b) without building the transpose.
+ * @return Matrix object of shape Rows x Cols.
+ */
+template <class T, int Rows, int Cols>
+template <int K>
+Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::dotTransposeB(const Matrix<T, Rows, K>& a, const Matrix<T, Cols, K>& b)
+{
+    Matrix<T, Rows, Cols> result;
+    for(int i = 0; i < Rows; i++)
+    {
+        for(int j = 0; j < Cols; j++)
+        {
+            T sum = 0;
+            for(int k = 0; k < K; k++)
+            {
+                sum += a(i,k) * b(j,k);
+            }
+            result(i,j) = sum;
+        }
+    }
+    return result;
+}
+/*!
+ * @details Subtracts each individual element in b from a.
+ * @return Matrix object of shape Rows x Cols.
+ */
+template <class T, int Rows, int Cols>
+Matrix<T, Rows, Cols> Matrix<T, Rows, Cols>::subtract(const Matrix<T, Rows, Cols>& a, const Matrix<T, Rows, Cols>& b)
+{
+    Matrix<T, Rows, Cols> result;
+    for(int i = 0; i < Rows * Cols; i++)
+    {
+        result.internalMatrix[i] = a.internalMatrix[i] - b.internalMatrix[i];
+    }
+    return result;
+}
+/*!
+ * @details Returns the transpose of a.
+ * @return Matrix object of shape Cols x Rows.
+ */
+template <class T, int Rows, int Cols>
+Matrix<T, Cols, Rows> Matrix<T, Rows, Cols>::transpose(const Matrix<T, Rows, Cols>& a)
+{
+    Matrix<T, Cols, Rows> result;
+    for(int i = 0; i < Rows; i++)
+    {
+        for(int j = 0; j < Cols; j++)
+        {
+            result(j,i) = a(i,j);
+        }
+    }
+    return result;
+}
+/*!
+ * @details Applies func to each element in place. func is a template parameter so a lambda can be inlined into the loop.
+ * @param func
+ */
+template <class T, int Rows, int Cols>
+template <class Func>
+void Matrix<T, Rows, Cols>::map(Func func)
+{
+    for(int i = 0; i < Rows * Cols; i++)
+    {
+        internalMatrix[i] = func(internalMatrix[i]);
+    }
+}
+/*!
+ * @details Multiplies each element by the matching element of a.
+ * @param a
+ */
+template <class T, int Rows, int Cols>
+void Matrix<T, Rows, Cols>::elementWiseMultiplyMatrix(const Matrix<T, Rows, Cols>& a)
+{
+    for(int i = 0; i < Rows * Cols; i++)
+    {
+        internalMatrix[i] *= a.internalMatrix[i];
+    }
+}
+/*!
+ * @details Multiplies each element by a scalar value.
+ * @param n
+ */
+template <class T, int Rows, int Cols>
+void Matrix<T, Rows, Cols>::elementWiseMulitpyScalar(T n)
+{
+    for(int i = 0; i < Rows * Cols; i++)
+    {
+        internalMatrix[i] *= n;
+    }
+}
+/*!
+ * @details Adds the matching element of a to each element.
+ * @param a
+ */
+template <class T, int Rows, int Cols>
+void Matrix<T, Rows, Cols>::elementWiseAddMatrix(const Matrix<T, Rows, Cols>& a)
+{
+    for(int i = 0; i < Rows * Cols; i++)
+    {
+        internalMatrix[i] += a.internalMatrix[i];
+    }
+}
+/*!
+ * @details Adds a scalar value to each element.
+ * @param n
+ */
+template <class T, int Rows, int Cols>
+void Matrix<T, Rows, Cols>::elementWiseAddScalar(T n)
+{
+    for(int i = 0; i < Rows * Cols; i++)
+    {
+        internalMatrix[i] += n;
+    }
+}
+/*!
+ * @details Fills the Matrix with the same distribution as Matrix<T>::randomize.
+ */
+template <class T, int Rows, int Cols>
+void Matrix<T, Rows, Cols>::randomize()
+{
+    randomizeUniform(0, 1);
+}
+/*!
+ * @details Fills the Matrix with the same distribution as Matrix<T>::xavierUniform.
+ */
+template <class T, int Rows, int Cols>
+void Matrix<T, Rows, Cols>::xavierUniform()
+{
+    T limit = std::sqrt(static_cast<T>(6) / (Rows + Cols));
+    randomizeUniform(-limit, limit);
+}
+/*!
+ * @details Fills the Matrix in place with values uniform in [low, high). Element (i, j) takes counter i * Cols + j of a fresh
+ * stream, the same value Matrix<T>::randomizeUniform gives it.
+ * @param low
+ * @param high
+ */
+template <class T, int Rows, int Cols>
+void Matrix<T, Rows, Cols>::randomizeUniform(T low, T high)
+{
+    const CounterRandom generator = CounterRandom::nextStream();
+    for(int i = 0; i < Rows * Cols; i++)
+    {
+        internalMatrix[i] = static_cast<T>(low + (high - low) * generator.uniform(i));
+    }
+}
+
+#endif /* fixedMatrix_h */
@@ -0,0 +1,143 @@
+//
+//  fixedNeuralNet.h
+//  Neural Net
+//
+//  NeuralNet with its topology fixed at compile time.
+//
+
+#ifndef fixedNeuralNet_h
+#define fixedNeuralNet_h
+
+#include <cmath>
+#include "fixedMatrix.h"
+
+/*!
+ * @details Same network and training rule as NeuralNet, with the layer sizes given as template arguments. Every buffer is a
+ * fixed shape Matrix stored inline, so there are no heap allocations and no runtime shape checks on the hot path.
+ * The weights of a wide layer are large (784x100 doubles is about 600KB), allocate the net with new or as a static
+ * rather than on a small thread stack.
+ * @tparam In input nodes
+ * @tparam Hidden hidden nodes
+ * @tparam Out output nodes
+ */
+template <int In, int Hidden, int Out>
+class FixedNeuralNet
+{
+public:
+    typedef Matrix<double, 1, In> InputMatrix;
+    typedef Matrix<double, 1, Out> OutputMatrix;
+
+    FixedNeuralNet();
+    void setLearningRate(double newRate){learningRate = newRate;}
+    double getLearningRate(){return learningRate;}
+    OutputMatrix feedForward(const InputMatrix& input);
+    Matrix<double> feedForward(const Matrix<double>& input);
+    void learn(const InputMatrix& input, const OutputMatrix& outputs);
+    void learn(const Matrix<double>& input, const Matrix<double>& outputs);
+    static double sigmoid(double x){return 1 / (1 + std::exp(-x));}
+    static double dSigmoid(double x){return std::exp(-x) / ((1 + std::exp(-x)) * (1 + std::exp(-x)));}
+
+    /*!
+     * @details new and new[] keep the member matrices aligned, see Matrix<T, Rows, Cols>::operator new.
+     */
+    static void* operator new(std::size_t size)
+    {
+        void* memory = nullptr;
+        if(posix_memalign(&memory, fixedMatrixAlignment, size) != 0) throw std::bad_alloc();
+        return memory;
+    }
+    static void* operator new[](std::size_t size){return operator new(size);}
+    static void operator delete(void* memory){std::free(memory);}
+    static void operator delete[](void* memory){std::free(memory);}
+private:
+    double learningRate;
+    Matrix<double, 1, Hidden> biasHidden;
+    Matrix<double, 1, Out> biasOutput;
+    Matrix<double, In, Hidden> weights_input_hidden;
+    Matrix<double, Hidden, Out> weights_hidden_output;
+    Matrix<double, 1, Out> Y;
+    Matrix<double, 1, Hidden> H;
+};
+
+template <int In, int Hidden, int Out>
+FixedNeuralNet<In, Hidden, Out>::FixedNeuralNet()
+{
+    weights_input_hidden.xavierUniform();
+    weights_hidden_output.xavierUniform();
+    learningRate = 0.25;
+}
+/*!
+ * @details Forward propagation, same as NeuralNet::feedForward.
+ * @return The output of the network.
+ */
+template <int In, int Hidden, int Out>
+typename FixedNeuralNet<In, Hidden, Out>::OutputMatrix FixedNeuralNet<In, Hidden, Out>::feedForward(const InputMatrix& input)
+{
+    H = Matrix<double, 1, Hidden>::dot(input, weights_input_hidden);
+    H.elementWiseAddMatrix(biasHidden);
+    H.map(sigmoid);
+
+    Y = Matrix<double, 1, Out>::dot(H, weights_hidden_output);
+    Y.elementWiseAddMatrix(biasOutput);
+    Y.map(sigmoid);
+    return Y;
+}
+/*!
+ * @details Forward propagation from a runtime sized 1 x In Matrix, throws std::invalid_argument on any other shape.
+ */
+template <int In, int Hidden, int Out>
+Matrix<double> FixedNeuralNet<In, Hidden, Out>::feedForward(const Matrix<double>& input)
+{
+    return feedForward(InputMatrix(input)).toDynamic();
+}
+/*!
+ * @details Backpropagation with the squared loss, same as NeuralNet::learn. Must follow a feedForward on the same input.
+ */
+template <int In, int Hidden, int Out>
+void FixedNeuralNet<In, Hidden, Out>::learn(const InputMatrix& input, const OutputMatrix& outputs)
+{
+    //derivitive of the loss function with respect to the bias, output layer
+    Matrix<double, 1, Out> DJdb2 = Matrix<double, 1, Out>::subtract(Y, outputs);
+    Matrix<double, 1, Out> temp = Matrix<double, 1, Out>::dot(H, weights_hidden_output);
+    temp.elementWiseAddMatrix(biasOutput);
+    temp.map(dSigmoid);
+    DJdb2.elementWiseMultiplyMatrix(temp);
+
+    //derivitive of the loss function with respect to the bias, input layer
+    Matrix<double, 1, Hidden> temp2 = Matrix<double, 1, Hidden>::dot(input, weights_input_hidden);
+    temp2.elementWiseAddMatrix(biasHidden);
+    temp2.map(dSigmoid);
+    Matrix<double, 1, Hidden> DJdb1 = Matrix<double, 1, Hidden>::dotTransposeB(DJdb2, weights_hidden_output);
+    DJdb1.elementWiseMultiplyMatrix(temp2);
+
+    //derivitives of the loss function with respect to the weights
+    Matrix<double, Hidden, Out> DJdw2 = Matrix<double, Hidden, Out>::dotTransposeA(H, DJdb2);
+
+    //step against the gradient, the input layer gradient is the outer product of input and DJdb1 and is applied as a
+    //rank one update instead of being built, it is as large as the weights
+    for(int k = 0; k < In; k++)
+    {
+        const double step = learningRate * input(0, k);
+        if(step == 0) continue;
+        for(int j = 0; j < Hidden; j++)
+        {
+            weights_input_hidden(k, j) -= step * DJdb1(0, j);
+        }
+    }
+    DJdw2.elementWiseMulitpyScalar(-learningRate);
+    DJdb1.elementWiseMulitpyScalar(-learningRate);
+    DJdb2.elementWiseMulitpyScalar(-learningRate);
+    weights_hidden_output.elementWiseAddMatrix(DJdw2);
+    biasHidden.elementWiseAddMatrix(DJdb1);
+    biasOutput.elementWiseAddMatrix(DJdb2);
+}
+/*!
+ * @details Backpropagation from runtime sized matrices, throws std::invalid_argument if they are not 1 x In and 1 x Out.
+ */
+template <int In, int Hidden, int Out>
+void FixedNeuralNet<In, Hidden, Out>::learn(const Matrix<double>& input, const Matrix<double>& outputs)
+{
+    learn(InputMatrix(input), OutputMatrix(outputs));
+}
+
+#endif /* fixedNeuralNet_h */
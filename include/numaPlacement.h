@@ -0,0 +1,439 @@
+//
+//  numaPlacement.h
+//  Neural Net
+//
+//  NUMA aware memory placement, huge pages and thread pinning.
+//
+
+#ifndef numaPlacement_h
+#define numaPlacement_h
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*!
+ * @details How large buffers are backed by pages. transparentHugePages advises the kernel to use 2MB pages,
+ * explicitHugePages maps from the hugetlbfs pool and falls back to transparent huge pages when the pool is empty.
+ */
+enum class HugePageMode
+{
+    none,
+    transparentHugePages,
+    explicitHugePages
+};
+
+/*!
+ * @details Where new buffers go. node -1 leaves placement to the kernel, which puts each page on the node of the thread
+ * that first touches it.
+ */
+struct MemoryPolicy
+{
+    MemoryPolicy():node(-1), hugePages(HugePageMode::none){}
+    MemoryPolicy(int userNode, HugePageMode userHugePages):node(userNode), hugePages(userHugePages){}
+    bool isDefault() const {return node < 0 && hugePages == HugePageMode::none;}
+    bool operator==(const MemoryPolicy& other) const {return node == other.node && hugePages == other.hugePages;}
+
+    int node;
+    HugePageMode hugePages;
+};
+
+/*!
+ * @details Linux NUMA helpers. Buffers of at least minimumMappedBytes allocated under a non default policy, which
+ * includes every Matrix of a data set or a weight layer, are mapped directly, bound to the policy's node and optionally
+ * backed by huge pages. Smaller buffers, such as single sample activations, come from operator new to keep system calls
+ * off the hot path. They land on the node of the first thread touching them, so create them from a thread pinned to the
+ * owning node, see runOnNode.
+ * On other platforms every call falls back to the default behavior and pinning reports failure.
+ */
+class MemoryPlacement
+{
+public:
+    static const std::size_t pageSize = 4096;
+    static const std::size_t hugePageSize = 2 * 1024 * 1024;
+    static const std::size_t minimumMappedBytes = 64 * 1024;
+
+    /*!
+     * @details Policy of the calling thread, changed with ScopedPlacement.
+     */
+    static MemoryPolicy& currentPolicy()
+    {
+        static thread_local MemoryPolicy policy;
+        return policy;
+    }
+    /*!
+     * @details Number of NUMA nodes, 1 when the machine reports none.
+     */
+    static int nodeCount()
+    {
+        int count = 0;
+        while(std::ifstream("/sys/devices/system/node/node" + std::to_string(count) + "/cpulist"))
+        {
+            count++;
+        }
+        return count > 0 ? count : 1;
+    }
+    /*!
+     * @details CPUs of a node, every hardware thread for node -1 or when the node is unknown.
+     */
+    static std::vector<int> nodeCpus(int node)
+    {
+        std::vector<int> cpus;
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+        if(node >= 0 && file >> list)
+        {
+            // format is "0-3,8,10-11"
+            std::stringstream ranges(list);
+            std::string range;
+            while(std::getline(ranges, range, ','))
+            {
+                std::size_t dash = range.find('-');
+                int first = std::stoi(range.substr(0, dash));
+                int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                for(int cpu = first; cpu <= last; cpu++)
+                {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+        if(cpus.empty())
+        {
+            int count = static_cast<int>(std::thread::hardware_concurrency());
+            for(int cpu = 0; cpu < (count > 0 ? count : 1); cpu++)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+    /*!
+     * @details Restricts the calling thread to one CPU.
+     * @return true on success.
+     */
+    static bool pinCurrentThread(int cpu)
+    {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        return false;
+#endif
+    }
+    /*!
+     * @details Restricts the calling thread to the CPUs of a node.
+     * @return true on success.
+     */
+    static bool pinCurrentThreadToNode(int node)
+    {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for(int cpu : nodeCpus(node))
+        {
+            CPU_SET(cpu, &set);
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        return false;
+#endif
+    }
+    /*!
+     * @details CPUs the calling thread may run on, every hardware thread when the affinity cannot be read.
+     */
+    static std::vector<int> currentCpus()
+    {
+        std::vector<int> cpus;
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if(pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0)
+        {
+            for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            {
+                if(CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+            }
+        }
+#endif
+        return cpus.empty() ? nodeCpus(-1) : cpus;
+    }
+    /*!
+     * @details When enabled, worker threads started by parallelFor and Evaluator pin themselves to a single CPU out of
+     * those allowed to the thread that started them. Off by default.
+     */
+    static void setPinWorkers(bool pin){pinWorkersFlag() = pin;}
+    static bool getPinWorkers(){return pinWorkersFlag();}
+    /*!
+     * @details Called first thing in a worker thread. Adopts the policy of the thread that started the worker, so its
+     * allocations and first touches follow the same placement, and pins it to CPU number index of the affinity it
+     * inherited from that thread if pinning is on.
+     * @param policy policy of the starting thread
+     * @param index worker number
+     */
+    static void startWorker(const MemoryPolicy& policy, int index)
+    {
+        currentPolicy() = policy;
+        if(!getPinWorkers()) return;
+        std::vector<int> cpus = currentCpus();
+        pinCurrentThread(cpus[index % cpus.size()]);
+    }
+    /*!
+     * @details Runs func on a new thread pinned to node with the given policy, so every buffer func creates is allocated
+     * and first touched on that node. Exceptions thrown by func are rethrown here.
+     */
+    static void runOnNode(int node, HugePageMode hugePages, const std::function<void ()>& func)
+    {
+        std::exception_ptr error;
+        std::thread worker([&]()
+        {
+            try
+            {
+                pinCurrentThreadToNode(node);
+                currentPolicy() = MemoryPolicy(node, hugePages);
+                func();
+            }
+            catch(...)
+            {
+                error = std::current_exception();
+            }
+        });
+        worker.join();
+        if(error) std::rethrow_exception(error);
+    }
+    /*!
+     * @details Allocates bytes under policy. deallocate must be given the same policy and size. Throws
+     * std::invalid_argument if the policy names a node the mbind mask cannot hold.
+     */
+    static void* allocate(std::size_t bytes, const MemoryPolicy& policy)
+    {
+#ifdef __linux__
+        if(isMapped(bytes, policy))
+        {
+            if(policy.node >= maximumNodes) throw std::invalid_argument("NUMA node out of range");
+            std::size_t length = mappedLength(bytes, policy);
+            void* memory = mappingCache().take(length, policy);
+            if(memory != nullptr) return memory;
+            memory = MAP_FAILED;
+            // a hugetlb mapping must be whole huge pages, which mappedLength only gives from hugePageSize up
+            if(policy.hugePages == HugePageMode::explicitHugePages && length % hugePageSize == 0)
+            {
+                memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            }
+            if(memory == MAP_FAILED)
+            {
+                memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if(memory == MAP_FAILED) throw std::bad_alloc();
+                if(policy.hugePages != HugePageMode::none) madvise(memory, length, MADV_HUGEPAGE);
+            }
+            if(policy.node >= 0) bindToNode(memory, length, policy.node);
+            return memory;
+        }
+#endif
+        return ::operator new(bytes);
+    }
+    /*!
+     * @details Releases a buffer from allocate. Runs inside container destructors so it cannot throw, a failed munmap is
+     * counted in unmapFailures instead. The last few mappings of up to largestCachedMapping bytes released by a thread
+     * are kept for reuse, so temporaries of the same size, such as the gradients of every training step, do not map and
+     * fault in fresh pages each time. Larger mappings, such as a whole data set, go straight back to the system.
+     */
+    static void deallocate(void* memory, std::size_t bytes, const MemoryPolicy& policy)
+    {
+#ifdef __linux__
+        if(isMapped(bytes, policy))
+        {
+            std::size_t length = mappedLength(bytes, policy);
+            if(!mappingCache().keep(memory, length, policy)) unmap(memory, length);
+            return;
+        }
+#endif
+        ::operator delete(memory);
+    }
+    /*!
+     * @details Mappings deallocate could not release, 0 unless a length was wrong.
+     */
+    static std::size_t unmapFailures(){return unmapFailureCount().load();}
+private:
+    static const int maximumNodes = static_cast<int>(sizeof(unsigned long) * 8); /*!< Nodes the mbind mask holds */
+    static const std::size_t cachedMappings = 8; /*!< Released mappings each thread keeps for reuse */
+    static const std::size_t largestCachedMapping = 4 * hugePageSize; /*!< Longest mapping kept, caps a cache at 64MB */
+
+#ifdef __linux__
+    static void unmap(void* memory, std::size_t length)
+    {
+        if(munmap(memory, length) != 0) unmapFailureCount()++;
+    }
+    /*!
+     * @details Mappings released by one thread, reused by later allocations of the same length and policy, which are
+     * already bound and faulted in. Holds at most cachedMappings of up to largestCachedMapping bytes, unmapped when the
+     * thread exits. The slots are reserved up front so keep never allocates inside deallocate.
+     */
+    class MappingCache
+    {
+    public:
+        MappingCache()
+        {
+            mappings.reserve(cachedMappings);
+        }
+        MappingCache(const MappingCache&) = delete;
+        MappingCache& operator=(const MappingCache&) = delete;
+        ~MappingCache()
+        {
+            for(const Mapping& mapping : mappings)
+            {
+                unmap(mapping.memory, mapping.length);
+            }
+        }
+        void* take(std::size_t length, const MemoryPolicy& policy)
+        {
+            for(std::size_t i = 0; i < mappings.size(); i++)
+            {
+                if(mappings[i].length != length || !(mappings[i].policy == policy)) continue;
+                void* memory = mappings[i].memory;
+                mappings[i] = mappings.back();
+                mappings.pop_back();
+                return memory;
+            }
+            return nullptr;
+        }
+        bool keep(void* memory, std::size_t length, const MemoryPolicy& policy)
+        {
+            if(mappings.size() >= cachedMappings || length > largestCachedMapping) return false;
+            Mapping mapping = {memory, length, policy};
+            mappings.push_back(mapping);
+            return true;
+        }
+    private:
+        struct Mapping
+        {
+            void* memory;
+            std::size_t length;
+            MemoryPolicy policy;
+        };
+        std::vector<Mapping> mappings;
+    };
+    static MappingCache& mappingCache()
+    {
+        static thread_local MappingCache cache;
+        return cache;
+    }
+#endif
+
+    static bool& pinWorkersFlag()
+    {
+        static bool pin = false;
+        return pin;
+    }
+    static std::atomic<std::size_t>& unmapFailureCount()
+    {
+        static std::atomic<std::size_t> count(0);
+        return count;
+    }
+    static bool isMapped(std::size_t bytes, const MemoryPolicy& policy)
+    {
+        return !policy.isDefault() && bytes >= minimumMappedBytes;
+    }
+    /*!
+     * @details Mapping length, whole huge pages for buffers of at least one huge page when they are requested, whole pages
+     * otherwise.
+     */
+    static std::size_t mappedLength(std::size_t bytes, const MemoryPolicy& policy)
+    {
+        std::size_t unit = pageSize;
+        if(policy.hugePages != HugePageMode::none && bytes >= hugePageSize) unit = hugePageSize;
+        return (bytes + unit - 1) / unit * unit;
+    }
+#ifdef __linux__
+    /*!
+     * @details Binds a mapping to a node with the mbind system call, called directly so there is no libnuma dependency.
+     * Pages are placed on the node at first touch whichever thread touches them. node must be below maximumNodes.
+     */
+    static void bindToNode(void* memory, std::size_t length, int node)
+    {
+        const int mpolBind = 2;
+        const unsigned mpolMfMove = 1 << 1;
+        unsigned long mask = 1UL << node;
+        // failure (e.g. a kernel without NUMA) leaves the default first touch placement
+        syscall(SYS_mbind, memory, length, mpolBind, &mask, sizeof(mask) * 8, mpolMfMove);
+    }
+#endif
+};
+
+/*!
+ * @details Sets the policy of the calling thread until the end of the scope.
+ */
+class ScopedPlacement
+{
+public:
+    ScopedPlacement(int node, HugePageMode hugePages = HugePageMode::none)
+    {
+        previous = MemoryPlacement::currentPolicy();
+        MemoryPlacement::currentPolicy() = MemoryPolicy(node, hugePages);
+    }
+    ~ScopedPlacement(){MemoryPlacement::currentPolicy() = previous;}
+    ScopedPlacement(const ScopedPlacement&) = delete;
+    ScopedPlacement& operator=(const ScopedPlacement&) = delete;
+private:
+    MemoryPolicy previous;
+};
+
+/*!
+ * @details Allocator used by Matrix storage, sparse matrices and data set buffers. It captures the calling thread's policy when constructed
+ * and places every buffer it allocates under that policy. A copy of a container takes the policy current at the copy,
+ * so data follows the scope it is created in. With the default policy it is plain operator new.
+ * @tparam T
+ */
+template <class T>
+class PlacementAllocator
+{
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    PlacementAllocator():policy(MemoryPlacement::currentPolicy()){}
+    template <class U>
+    PlacementAllocator(const PlacementAllocator<U>& other):policy(other.getPolicy()){}
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(MemoryPlacement::allocate(n * sizeof(T), this->policy));
+    }
+    void deallocate(T* memory, std::size_t n)
+    {
+        MemoryPlacement::deallocate(memory, n * sizeof(T), this->policy);
+    }
+    PlacementAllocator select_on_container_copy_construction() const
+    {
+        return PlacementAllocator();
+    }
+    const MemoryPolicy& getPolicy() const {return policy;}
+private:
+    MemoryPolicy policy;
+};
+
+template <class T, class U>
+bool operator==(const PlacementAllocator<T>& a, const PlacementAllocator<U>& b){return a.getPolicy() == b.getPolicy();}
+template <class T, class U>
+bool operator!=(const PlacementAllocator<T>& a, const PlacementAllocator<U>& b){return !(a == b);}
+
+#endif /* numaPlacement_h */
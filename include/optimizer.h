@@ -0,0 +1,159 @@
+//
+//  optimizer.h
+//  Neural Net
+//
+//  Gradient descent optimizers and learning rate schedules.
+//
+
+#ifndef optimizer_h
+#define optimizer_h
+
+#include <memory>
+#include <vector>
+#include "matrix.h"
+
+/*!
+ * @details Maps the base learning rate and the step number (starting at 1) to the rate used for that step.
+ */
+class LearningRateSchedule
+{
+public:
+    virtual ~LearningRateSchedule(){}
+    virtual double rate(double baseRate, int step) const = 0;
+};
+/*!
+ * @details Always the base rate.
+ */
+class ConstantSchedule : public LearningRateSchedule
+{
+public:
+    double rate(double baseRate, int step) const override;
+};
+/*!
+ * @details baseRate * gamma^((step - 1) / stepSize) with integer division, the rate drops by gamma every stepSize steps.
+ */
+class StepDecaySchedule : public LearningRateSchedule
+{
+public:
+    StepDecaySchedule(int stepSize, double gamma);
+    double rate(double baseRate, int step) const override;
+private:
+    int stepSize;
+    double gamma;
+};
+/*!
+ * @details baseRate * decay^(step - 1), so step 1 runs at the base rate.
+ */
+class ExponentialDecaySchedule : public LearningRateSchedule
+{
+public:
+    explicit ExponentialDecaySchedule(double decay);
+    double rate(double baseRate, int step) const override;
+private:
+    double decay;
+};
+/*!
+ * @details baseRate / (1 + decay * (step - 1)), so step 1 runs at the base rate.
+ */
+class InverseTimeSchedule : public LearningRateSchedule
+{
+public:
+    explicit InverseTimeSchedule(double decay);
+    double rate(double baseRate, int step) const override;
+private:
+    double decay;
+};
+
+/*!
+ * @details Base class of all optimizers. Each trainable Matrix is identified by a slot number, optimizers with state keep
+ * one state Matrix per slot and size it on first use. Call beginStep once per training step, then update for every slot.
+ * Every update is a single pass over the parameter, gradient and state rows.
+ */
+class Optimizer
+{
+public:
+    explicit Optimizer(double learningRate);
+    virtual ~Optimizer(){}
+    void beginStep();
+    virtual void update(int slot, Matrix<double>& param, const Matrix<double>& grad) = 0;
+    /*!
+     * @details Independent copy including the per slot state and the step counter, used when a NeuralNet is copied so
+     * the copies train separately. The schedule is stateless and stays shared.
+     */
+    virtual std::shared_ptr<Optimizer> clone() const = 0;
+    /*!
+     * @details True if update is exactly param -= currentRate() * grad, which lets callers apply sparse gradients in place.
+     */
+    virtual bool isStateless() const {return false;}
+    void setLearningRate(double newRate){learningRate = newRate;}
+    double getLearningRate() const {return learningRate;}
+    double currentRate() const {return rate;}
+    int getStep() const {return step;}
+    void setSchedule(std::shared_ptr<LearningRateSchedule> newSchedule);
+protected:
+    static Matrix<double>& stateFor(std::vector<Matrix<double> >& state, int slot, const Matrix<double>& param);
+    static void validateGradient(const Matrix<double>& param, const Matrix<double>& grad);
+private:
+    double learningRate; /*!< Base rate, before the schedule is applied */
+    double rate; /*!< Rate of the current step */
+    int step; /*!< Steps started with beginStep */
+    std::shared_ptr<LearningRateSchedule> schedule;
+};
+/*!
+ * @details Plain stochastic gradient descent, param -= rate * grad.
+ */
+class SGD : public Optimizer
+{
+public:
+    explicit SGD(double learningRate);
+    void update(int slot, Matrix<double>& param, const Matrix<double>& grad) override;
+    std::shared_ptr<Optimizer> clone() const override {return std::make_shared<SGD>(*this);}
+    bool isStateless() const override {return true;}
+};
+/*!
+ * @details Heavy ball momentum, v = momentum * v + grad, param -= rate * v. With nesterov set the step looks ahead along
+ * the velocity, param -= rate * (grad + momentum * v).
+ */
+class Momentum : public Optimizer
+{
+public:
+    Momentum(double learningRate, double momentum = 0.9, bool nesterov = false);
+    void update(int slot, Matrix<double>& param, const Matrix<double>& grad) override;
+    std::shared_ptr<Optimizer> clone() const override {return std::make_shared<Momentum>(*this);}
+private:
+    double momentum;
+    bool nesterov;
+    std::vector<Matrix<double> > velocity;
+};
+/*!
+ * @details RMSProp, s = decay * s + (1 - decay) * grad^2, param -= rate * grad / (sqrt(s) + epsilon).
+ */
+class RMSProp : public Optimizer
+{
+public:
+    RMSProp(double learningRate, double decay = 0.9, double epsilon = 1e-8);
+    void update(int slot, Matrix<double>& param, const Matrix<double>& grad) override;
+    std::shared_ptr<Optimizer> clone() const override {return std::make_shared<RMSProp>(*this);}
+private:
+    double decay;
+    double epsilon;
+    std::vector<Matrix<double> > meanSquare;
+};
+/*!
+ * @details Adam with bias corrected first and second moment estimates.
+ */
+class Adam : public Optimizer
+{
+public:
+    Adam(double learningRate, double beta1 = 0.9, double beta2 = 0.999, double epsilon = 1e-8);
+    void update(int slot, Matrix<double>& param, const Matrix<double>& grad) override;
+    std::shared_ptr<Optimizer> clone() const override {return std::make_shared<Adam>(*this);}
+private:
+    double beta1;
+    double beta2;
+    double epsilon;
+    std::vector<Matrix<double> > firstMoment;
+    std::vector<Matrix<double> > secondMoment;
+};
+
+#endif /* optimizer_h */
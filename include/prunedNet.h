@@ -0,0 +1,40 @@
+//
+//  prunedNet.h
+//  Neural Net
+//
+//  Inference only network with a block sparse input layer.
+//
+
+#ifndef prunedNet_h
+#define prunedNet_h
+
+#include <string>
+#include "matrix.h"
+#include "blockSparseMatrix.h"
+#include "NeuralNet.h"
+
+/*!
+ * @details Inference copy of a pruned NeuralNet. The input layer weights are stored as a BlockSparseMatrix, so prediction
+ * only multiplies the stored tiles and the model file only holds those. By default the tiles match the shape the net was
+ * last pruned with, other shapes leave few tiles empty.
+ */
+class PrunedNet
+{
+public:
+    PrunedNet();
+    explicit PrunedNet(const NeuralNet& net);
+    PrunedNet(const NeuralNet& net, int blockRows, int blockCols);
+    Matrix<double> predict(const Matrix<double>& input) const;
+    void saveModel(std::string fileName) const;
+    void loadModel(std::string fileName);
+    int getInputNodes() const {return weights_input_hidden.getRows();}
+    int getOutputNodes() const {return weights_hidden_output.getColumns();}
+    double inputLayerDensity() const {return weights_input_hidden.density();}
+private:
+    BlockSparseMatrix<double> weights_input_hidden;
+    Matrix<double> weights_hidden_output;
+    Matrix<double> biasHidden;
+    Matrix<double> biasOutput;
+};
+
+#endif /* prunedNet_h */
@@ -0,0 +1,130 @@
+//
+//  pruning.h
+//  Neural Net
+//
+//  Magnitude pruning of weight matrices.
+//
+
+#ifndef pruning_h
+#define pruning_h
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include "matrix.h"
+
+/*!
+ * @details Mean absolute value of every blockRows x blockCols tile of weights, in row major tile order. Edge tiles only
+ * average the part inside the Matrix.
+ */
+template <typename T>
+std::vector<T> blockMagnitudes(const Matrix<T>& weights, int blockRows, int blockCols)
+{
+    if(blockRows <= 0 || blockCols <= 0) throw std::invalid_argument("Block dims must be positive");
+    std::vector<T> scores;
+    for(int r0 = 0; r0 < weights.getRows(); r0 += blockRows)
+    {
+        const int rEnd = std::min(r0 + blockRows, weights.getRows());
+        for(int c0 = 0; c0 < weights.getColumns(); c0 += blockCols)
+        {
+            const int cEnd = std::min(c0 + blockCols, weights.getColumns());
+            T sum = 0;
+            for(int i = r0; i < rEnd; i++)
+            {
+                const T* row = weights.rowPointer(i);
+                for(int j = c0; j < cEnd; j++)
+                {
+                    sum += std::abs(row[j]);
+                }
+            }
+            scores.push_back(sum / ((rEnd - r0) * (cEnd - c0)));
+        }
+    }
+    return scores;
+}
+/*!
+ * @details Builds a 0/1 mask the shape of weights from one keep flag per tile, in the order of blockMagnitudes.
+ */
+template <typename T>
+Matrix<T> blockMask(const Matrix<T>& weights, const std::vector<bool>& keep, int blockRows, int blockCols)
+{
+    Matrix<T> mask(weights.getRows(), weights.getColumns());
+    int block = 0;
+    for(int r0 = 0; r0 < weights.getRows(); r0 += blockRows)
+    {
+        const int rEnd = std::min(r0 + blockRows, weights.getRows());
+        for(int c0 = 0; c0 < weights.getColumns(); c0 += blockCols, block++)
+        {
+            if(!keep[block]) continue;
+            const int cEnd = std::min(c0 + blockCols, weights.getColumns());
+            for(int i = r0; i < rEnd; i++)
+            {
+                T* row = mask.rowPointer(i);
+                for(int j = c0; j < cEnd; j++)
+                {
+                    row[j] = 1;
+                }
+            }
+        }
+    }
+    return mask;
+}
+/*!
+ * @details Zeroes every tile of weights whose mean absolute value is below threshold. With 1x1 tiles this is plain
+ * magnitude pruning, larger tiles prune whole blocks so the result suits BlockSparseMatrix.
+ * @param weights pruned in place
+ * @param threshold
+ * @param blockRows
+ * @param blockCols
+ * @return 0/1 mask of the kept weights, multiply it back in after a training step to keep the sparsity fixed.
+ */
+template <typename T>
+Matrix<T> pruneByThreshold(Matrix<T>& weights, T threshold, int blockRows = 1, int blockCols = 1)
+{
+    std::vector<T> scores = blockMagnitudes(weights, blockRows, blockCols);
+    std::vector<bool> keep(scores.size());
+    for(std::size_t b = 0; b < scores.size(); b++)
+    {
+        keep[b] = scores[b] >= threshold;
+    }
+    Matrix<T> mask = blockMask(weights, keep, blockRows, blockCols);
+    weights.elementWiseMultiplyMatrix(mask);
+    return mask;
+}
+/*!
+ * @details Zeroes the fraction sparsity of tiles with the smallest mean absolute value. Throws std::invalid_argument if
+ * sparsity is outside [0, 1].
+ * @param weights pruned in place
+ * @param sparsity fraction of tiles to remove
+ * @param blockRows
+ * @param blockCols
+ * @return 0/1 mask of the kept weights.
+ */
+template <typename T>
+Matrix<T> pruneToSparsity(Matrix<T>& weights, double sparsity, int blockRows = 1, int blockCols = 1)
+{
+    if(sparsity < 0 || sparsity > 1) throw std::invalid_argument("Sparsity must be between 0 and 1");
+    std::vector<T> scores = blockMagnitudes(weights, blockRows, blockCols);
+    std::vector<int> order(scores.size());
+    for(std::size_t b = 0; b < order.size(); b++)
+    {
+        order[b] = static_cast<int>(b);
+    }
+    const std::size_t pruned = static_cast<std::size_t>(sparsity * scores.size());
+    std::vector<bool> keep(scores.size(), true);
+    if(pruned > 0)
+    {
+        std::nth_element(order.begin(), order.begin() + (pruned - 1), order.end(),
+                         [&scores](int x, int y){return scores[x] < scores[y];});
+        for(std::size_t b = 0; b < pruned; b++)
+        {
+            keep[order[b]] = false;
+        }
+    }
+    Matrix<T> mask = blockMask(weights, keep, blockRows, blockCols);
+    weights.elementWiseMultiplyMatrix(mask);
+    return mask;
+}
+
+#endif /* pruning_h */
@@ -0,0 +1,135 @@
+//
+//  randomGenerator.h
+//  Neural Net
+//
+//  Counter based random numbers for filling matrices.
+//
+
+#ifndef randomGenerator_h
+#define randomGenerator_h
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+#include "numaPlacement.h"
+
+/*!
+ * @details Counter based generator in the style of SplitMix64. The value for a counter is a hash of (seed, stream, counter),
+ * so any element of a fill can be produced independently of the others, in any order and on any thread, and the result
+ * never depends on how the work was split. Every fill takes a fresh stream from nextStream, after setGlobalSeed the
+ * sequence of fills is reproducible.
+ */
+class CounterRandom
+{
+public:
+    CounterRandom(std::uint64_t seed, std::uint64_t stream)
+    {
+        this->key = mix(seed ^ mix(stream + golden));
+    }
+    /*!
+     * @details Generator for the next stream of the global seed.
+     */
+    static CounterRandom nextStream()
+    {
+        return CounterRandom(getGlobalSeed(), streamCounter().fetch_add(1));
+    }
+    /*!
+     * @details Sets the global seed and restarts the stream sequence. Until this is called the seed comes from
+     * std::random_device, so runs differ.
+     */
+    static void setGlobalSeed(std::uint64_t seed)
+    {
+        globalSeed().store(seed);
+        streamCounter().store(0);
+    }
+    static std::uint64_t getGlobalSeed(){return globalSeed().load();}
+    /*!
+     * @details Number of streams handed out since the seed was set. Restoring it with setStreamPosition after
+     * setGlobalSeed resumes the sequence of fills where it was.
+     */
+    static std::uint64_t getStreamPosition(){return streamCounter().load();}
+    static void setStreamPosition(std::uint64_t position){streamCounter().store(position);}
+
+    std::uint64_t bits(std::uint64_t counter) const{return mix(this->key + counter * golden);}
+    /*!
+     * @details Uniform double in [0, 1) from the top 53 bits.
+     */
+    double uniform(std::uint64_t counter) const
+    {
+        return (bits(counter) >> 11) * (1.0 / 9007199254740992.0);
+    }
+    /*!
+     * @details Standard normal value by Box-Muller, uses the counters 2 * counter and 2 * counter + 1.
+     */
+    double normal(std::uint64_t counter) const
+    {
+        const double twoPi = 6.283185307179586;
+        double u1 = 1.0 - uniform(2 * counter);
+        double u2 = uniform(2 * counter + 1);
+        return std::sqrt(-2.0 * std::log(u1)) * std::cos(twoPi * u2);
+    }
+    /*!
+     * @details Calls func(begin, end) over [0, count) split between hardware threads. Runs inline when the total work,
+     * count * cost, is below parallelThreshold. Workers inherit the caller's MemoryPolicy, so first touches stay on its node.
+     * @param count
+     * @param cost work per item
+     * @param func
+     */
+    template <class Func>
+    static void parallelFor(int count, int cost, Func func)
+    {
+        int threads = static_cast<int>(std::thread::hardware_concurrency());
+        if(threads <= 1 || static_cast<long long>(count) * cost < parallelThreshold || count < 2)
+        {
+            func(0, count);
+            return;
+        }
+        if(threads > count) threads = count;
+        std::vector<std::thread> workers;
+        const MemoryPolicy policy = MemoryPlacement::currentPolicy();
+        int chunk = (count + threads - 1) / threads;
+        int index = 1;
+        for(int begin = chunk; begin < count; begin += chunk, index++)
+        {
+            int end = begin + chunk < count ? begin + chunk : count;
+            workers.push_back(std::thread([policy, index, begin, end, &func]()
+            {
+                MemoryPlacement::startWorker(policy, index);
+                func(begin, end);
+            }));
+        }
+        func(0, chunk < count ? chunk : count);
+        for(std::thread& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    static const long long parallelThreshold = 1 << 18; /*!< Elements below which a fill stays on the calling thread */
+private:
+    static const std::uint64_t golden = 0x9E3779B97F4A7C15ULL;
+
+    static std::uint64_t mix(std::uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    static std::atomic<std::uint64_t>& globalSeed()
+    {
+        static std::atomic<std::uint64_t> seed((static_cast<std::uint64_t>(std::random_device()()) << 32) ^ std::random_device()());
+        return seed;
+    }
+    static std::atomic<std::uint64_t>& streamCounter()
+    {
+        static std::atomic<std::uint64_t> counter(0);
+        return counter;
+    }
+
+    std::uint64_t key;
+};
+
+#endif /* randomGenerator_h */
@@ -0,0 +1,261 @@
+//
+//  sparseMatrix.h
+//  Neural Net
+//
+//  Compressed sparse row Matrix, used for mostly zero inputs such as digit images.
+//
+
+#ifndef sparseMatrix_h
+#define sparseMatrix_h
+
+#include <vector>
+#include <stdexcept>
+#include "matrix.h"
+
+/*!
+ * @details Matrix stored in compressed sparse row (CSR) form. Row i owns the entries rowStart[i] to rowStart[i + 1] of
+ * columnIndex and values. Rows are built in order with pushBack and endRow.
+ * @tparam T
+ */
+template <class T>
+class SparseMatrix
+{
+public:
+    SparseMatrix();
+    SparseMatrix(int userRows, int userCols);
+    static SparseMatrix<T> fromDense(const Matrix<T>& a);
+    Matrix<T> toDense() const;
+    SparseMatrix<T> rowSlice(int begin, int end) const;
+    SparseMatrix<T> operator[](int i) const{return rowSlice(i, i + 1);}
+
+    static Matrix<T> dot(const SparseMatrix<T>& a, const Matrix<T>& b);
+    static Matrix<T> transposeDot(const SparseMatrix<T>& a, const Matrix<T>& b);
+    static void subtractScaledTransposeDot(Matrix<T>& c, const SparseMatrix<T>& a, const Matrix<T>& b, T scale);
+
+    void pushBack(int column, T value);
+    void endRow();
+    int getRows()const{return rows;}
+    int getColumns()const{return columns;}
+    int nonZeros()const{return static_cast<int>(values.size());}
+    std::vector<int> nonZeroColumns() const;
+    double density()const;
+private:
+    int rows; /*!< Rows finished with endRow */
+
+    int columns; /*!< Matrix columns */
+
+    std::vector<int, PlacementAllocator<int> > rowStart; /*!< Offset of each row in columnIndex and values, has rows + 1 entries */
+
+    std::vector<int, PlacementAllocator<int> > columnIndex; /*!< Column of each stored value */
+
+    std::vector<T, PlacementAllocator<T> > values; /*!< Stored non zero values */
+};
+/*!
+ * @details Empty 0x0 Matrix.
+ */
+template <typename T>
+SparseMatrix<T>::SparseMatrix():SparseMatrix(0,0){}
+/*!
+ * @details Creates a Matrix with userCols columns and no rows, rows are then appended with pushBack and endRow. userRows
+ * is only used to reserve space. Throws std::out_of_range if either argument is negative.
+ * @param userRows
+ * @param userCols
+ */
+template <typename T>
+SparseMatrix<T>::SparseMatrix(int userRows, int userCols)
+{
+    if(userRows < 0 || userCols < 0) throw std::out_of_range("Matrix dims must be non-negative");
+    this->rows = 0;
+    this->columns = userCols;
+    this->rowStart.reserve(userRows + 1);
+    this->rowStart.push_back(0);
+}
+/*!
+ * @details Compresses a dense Matrix, only non zero elements are stored.
+ * @param a
+ * @return SparseMatrix object of type T.
+ */
+template <typename T>
+SparseMatrix<T> SparseMatrix<T>::fromDense(const Matrix<T>& a)
+{
+    SparseMatrix<T> result(a.getRows(), a.getColumns());
+    for(int i = 0; i < a.getRows(); i++)
+    {
+        const T* row = a.rowPointer(i);
+        for(int j = 0; j < a.getColumns(); j++)
+        {
+            if(row[j] != T(0)) result.pushBack(j, row[j]);
+        }
+        result.endRow();
+    }
+    return result;
+}
+/*!
+ * @details Expands into a dense Matrix.
+ * @return Matrix object of type T.
+ */
+template <typename T>
+Matrix<T> SparseMatrix<T>::toDense() const
+{
+    Matrix<T> result(this->rows, this->columns);
+    for(int i = 0; i < this->rows; i++)
+    {
+        T* row = result.rowPointer(i);
+        for(int p = this->rowStart[i]; p < this->rowStart[i + 1]; p++)
+        {
+            row[this->columnIndex[p]] = this->values[p];
+        }
+    }
+    return result;
+}
+/*!
+ * @details Returns rows [begin, end) as a new SparseMatrix, this is how a batch is cut out of a loaded data set. Throws
+ * std::out_of_range if the range is not inside the Matrix.
+ * @param begin
+ * @param end
+ * @return SparseMatrix object of type T.
+ */
+template <typename T>
+SparseMatrix<T> SparseMatrix<T>::rowSlice(int begin, int end) const
+{
+    if(begin < 0 || end > this->rows || begin > end) throw std::out_of_range("Matrix access out of bounds");
+    SparseMatrix<T> result(end - begin, this->columns);
+    const int first = this->rowStart[begin];
+    const int last = this->rowStart[end];
+    result.columnIndex.assign(this->columnIndex.begin() + first, this->columnIndex.begin() + last);
+    result.values.assign(this->values.begin() + first, this->values.begin() + last);
+    for(int i = begin + 1; i <= end; i++)
+    {
+        result.rowStart.push_back(this->rowStart[i] - first);
+    }
+    result.rows = end - begin;
+    return result;
+}
+/*!
+ * @details Sparse times dense product a * b, only the rows of b matching a stored value are read. Throws
+ * std::invalid_argument if the dims cannot be multiplied.
+ * @param a
+ * @param b
+ * @return Matrix object of type T.
+ */
+template <typename T>
+Matrix<T> SparseMatrix<T>::dot(const SparseMatrix<T>& a, const Matrix<T>& b)
+{
+    if(a.getColumns() != b.getRows())
+    {
+        throw std::invalid_argument("Matrix dims cannot be multiplied");
+    }
+    Matrix<T> result(a.getRows(), b.getColumns());
+    const int resultCols = b.getColumns();
+    for(int i = 0; i < a.getRows(); i++)
+    {
+        T* cRow = result.rowPointer(i);
+        for(int p = a.rowStart[i]; p < a.rowStart[i + 1]; p++)
+        {
+            const T value = a.values[p];
+            const T* bRow = b.rowPointer(a.columnIndex[p]);
+            for(int j = 0; j < resultCols; j++)
+            {
+                cRow[j] += value * bRow[j];
+            }
+        }
+    }
+    return result;
+}
+/*!
+ * @details Computes transpose(a) * b, a sum of outer products of the rows of a and b. Rows of the result whose column
+ * holds no value in a stay zero and are never written. Throws std::invalid_argument if the dims cannot be multiplied.
+ * @param a
+ * @param b
+ * @return Matrix object of type T.
+ */
+template <typename T>
+Matrix<T> SparseMatrix<T>::transposeDot(const SparseMatrix<T>& a, const Matrix<T>& b)
+{
+    Matrix<T> result(a.getColumns(), b.getColumns());
+    subtractScaledTransposeDot(result, a, b, T(-1));
+    return result;
+}
+/*!
+ * @details Fused gradient step c -= scale * transpose(a) * b. Only the rows of c matching a stored column of a are touched,
+ * for a first layer weight Matrix these are the weights of the non zero inputs. Throws std::invalid_argument if the
+ * dims do not agree.
+ * @param c
+ * @param a
+ * @param b
+ * @param scale
+ */
+template <typename T>
+void SparseMatrix<T>::subtractScaledTransposeDot(Matrix<T>& c, const SparseMatrix<T>& a, const Matrix<T>& b, T scale)
+{
+    if(a.getRows() != b.getRows() || c.getRows() != a.getColumns() || c.getColumns() != b.getColumns())
+    {
+        throw std::invalid_argument("Matrix dims cannot be multiplied");
+    }
+    const int resultCols = b.getColumns();
+    for(int i = 0; i < a.getRows(); i++)
+    {
+        const T* bRow = b.rowPointer(i);
+        for(int p = a.rowStart[i]; p < a.rowStart[i + 1]; p++)
+        {
+            const T value = scale * a.values[p];
+            T* cRow = c.rowPointer(a.columnIndex[p]);
+            for(int j = 0; j < resultCols; j++)
+            {
+                cRow[j] -= value * bRow[j];
+            }
+        }
+    }
+}
+/*!
+ * @details Appends a value to the row currently being built. Throws std::out_of_range if column is outside the Matrix.
+ * @param column
+ * @param value
+ */
+template <typename T>
+void SparseMatrix<T>::pushBack(int column, T value)
+{
+    if(column < 0 || column >= this->columns) throw std::out_of_range("Matrix access out of bounds");
+    this->columnIndex.push_back(column);
+    this->values.push_back(value);
+}
+/*!
+ * @details Finishes the row currently being built.
+ */
+template <typename T>
+void SparseMatrix<T>::endRow()
+{
+    this->rowStart.push_back(static_cast<int>(this->values.size()));
+    this->rows++;
+}
+/*!
+ * @details Columns holding at least one stored value, in increasing order.
+ * @return std::vector<int> of column indices.
+ */
+template <typename T>
+std::vector<int> SparseMatrix<T>::nonZeroColumns() const
+{
+    std::vector<bool> used(this->columns, false);
+    for(int column : this->columnIndex)
+    {
+        used[column] = true;
+    }
+    std::vector<int> result;
+    for(int j = 0; j < this->columns; j++)
+    {
+        if(used[j]) result.push_back(j);
+    }
+    return result;
+}
+/*!
+ * @details Fraction of elements that are stored, 0 for an empty Matrix.
+ * @return double between 0 and 1.
+ */
+template <typename T>
+double SparseMatrix<T>::density() const
+{
+    double total = static_cast<double>(this->rows) * this->columns;
+    return total == 0 ? 0 : this->values.size() / total;
+}
+
+#endif /* sparseMatrix_h */
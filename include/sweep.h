@@ -0,0 +1,66 @@
+//
+//  sweep.h
+//  Neural Net
+//
+//  Trains many small networks side by side for hyperparameter sweeps.
+//
+
+#ifndef sweep_h
+#define sweep_h
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "matrix.h"
+#include "NeuralNet.h"
+
+/*!
+ * @details One model of a sweep.
+ */
+struct SweepConfig
+{
+    int hiddenNodes;
+    double learningRate;
+    std::uint64_t seed; /*!< Initial weights match NeuralNet(inputs, hiddenNodes, outputs) after CounterRandom::setGlobalSeed(seed) */
+};
+/*!
+ * @details Per model result of one pass over a data set.
+ */
+struct SweepResult
+{
+    SweepConfig config;
+    int samples;
+    double loss; /*!< Mean over samples of the squared error against the one hot label */
+    double accuracy;
+
+    friend std::ostream& operator<<(std::ostream& stream, const SweepResult& result);
+};
+
+/*!
+ * @details Trains several inputs x hidden x outputs networks with SGD on the same data in a single pass. The input layers of
+ * all models are stored side by side in one inputs x (sum of hidden) Matrix, so the forward product and the weight
+ * gradient of the input layer are each one wide GEMM per batch instead of one small GEMM per model. The output layers
+ * are small and stay per model. Each model follows the same training rule as NeuralNet::learn with SGD up to rounding.
+ */
+class SweepRunner
+{
+public:
+    SweepRunner(int inputNodes, int outputNodes, const std::vector<SweepConfig>& configs);
+    std::vector<SweepResult> trainEpoch(const Matrix<double>& inputs, const std::vector<int>& labels, int batchSize = 1);
+    std::vector<SweepResult> evaluate(const Matrix<double>& inputs, const std::vector<int>& labels, int batchSize = 64) const;
+    NeuralNet model(int index) const;
+    int models() const {return static_cast<int>(configs.size());}
+private:
+    void validateData(const Matrix<double>& inputs, const std::vector<int>& labels, int batchSize) const;
+    Matrix<double> hiddenSum(const Matrix<double>& batch) const;
+    int inputNodes;
+    int outputNodes;
+    std::vector<SweepConfig> configs;
+    std::vector<int> hiddenOffset; /*!< First column of each model in the stacked input layer */
+    Matrix<double> weights_input_hidden; /*!< Input layers of all models, side by side */
+    Matrix<double> biasHidden; /*!< Hidden biases of all models, side by side */
+    std::vector<Matrix<double> > weights_hidden_output;
+    std::vector<Matrix<double> > biasOutput;
+};
+
+#endif /* sweep_h */
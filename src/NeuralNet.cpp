@@ -7,6 +7,19 @@
 //
 
 #include "NeuralNet.h"
+#include "pruning.h"
+
+/*
+ * Optimizer slot of each trainable Matrix
+ */
+enum
+{
+    inputHiddenSlot,
+    hiddenOutputSlot,
+    biasHiddenSlot,
+    biasOutputSlot
+};
+
  NeuralNet::NeuralNet(int inputNodesA, int hiddenNodesA, int outputNodesA)
 {
 	
@@ -14,19 +27,79 @@
     this->hidden_nodes = hiddenNodesA;
     this->output_nodes = outputNodesA;	
    
+    // biases start at 0, weights use Xavier initialization which keeps the sigmoid out of saturation
     this->biasHidden = Matrix<double>(1, hiddenNodesA);
-    this->biasHidden.randomize();
     this->biasOutput= Matrix<double>(1, outputNodesA);
-    this->biasOutput.randomize();
     this->weights_input_hidden = Matrix<double>(inputNodesA, hiddenNodesA);
-    this->weights_input_hidden.randomize();
+    this->weights_input_hidden.xavierUniform();
     this->weights_hidden_output= Matrix<double>(hiddenNodesA,outputNodesA);
-    this->weights_hidden_output.randomize();
-    this->learningRate = 0.25;
+    this->weights_hidden_output.xavierUniform();
+    this->optimizer = std::make_shared<SGD>(0.25);
+    this->sparseDensityThreshold = 0.3;
+    this->pruneBlockRows = defaultPruneBlock;
+    this->pruneBlockCols = defaultPruneBlock;
 }
-void NeuralNet::setLearningRate(int newRate)
+/*!
+ * @details Builds a net from existing weights, e.g. ones trained elsewhere. Throws std::invalid_argument if the shapes do
+ * not describe a inputs x hidden x outputs network.
+ */
+NeuralNet::NeuralNet(const Matrix<double>& weightsInputHidden, const Matrix<double>& weightsHiddenOutput,
+                     const Matrix<double>& hiddenBias, const Matrix<double>& outputBias)
+{
+    if(weightsHiddenOutput.getRows() != weightsInputHidden.getColumns()
+       || hiddenBias.getRows() != 1 || hiddenBias.getColumns() != weightsInputHidden.getColumns()
+       || outputBias.getRows() != 1 || outputBias.getColumns() != weightsHiddenOutput.getColumns())
+    {
+        throw std::invalid_argument("Weight dims do not form a network");
+    }
+    this->input_nodes = weightsInputHidden.getRows();
+    this->hidden_nodes = weightsInputHidden.getColumns();
+    this->output_nodes = weightsHiddenOutput.getColumns();
+    this->biasHidden = hiddenBias;
+    this->biasOutput = outputBias;
+    this->weights_input_hidden = weightsInputHidden;
+    this->weights_hidden_output = weightsHiddenOutput;
+    this->optimizer = std::make_shared<SGD>(0.25);
+    this->sparseDensityThreshold = 0.3;
+    this->pruneBlockRows = defaultPruneBlock;
+    this->pruneBlockCols = defaultPruneBlock;
+}
+/*!
+ * @details Copies the weights and clones the optimizer, so the copy continues from the same optimizer state but the two
+ * nets train independently.
+ */
+NeuralNet::NeuralNet(const NeuralNet& other)
+    :input_nodes(other.input_nodes), hidden_nodes(other.hidden_nodes), output_nodes(other.output_nodes),
+     optimizer(other.optimizer->clone()), sparseDensityThreshold(other.sparseDensityThreshold),
+     biasHidden(other.biasHidden), biasOutput(other.biasOutput), weights_input_hidden(other.weights_input_hidden),
+     weights_hidden_output(other.weights_hidden_output), inputHiddenMask(other.inputHiddenMask),
+     pruneBlockRows(other.pruneBlockRows), pruneBlockCols(other.pruneBlockCols), Y(other.Y), H(other.H)
 {
-    this->learningRate = newRate;
+}
+/*!
+ * @details Copy assignment, clones the optimizer like the copy constructor.
+ */
+NeuralNet& NeuralNet::operator=(const NeuralNet& other)
+{
+    if(this != &other)
+    {
+        NeuralNet copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+void NeuralNet::setLearningRate(double newRate)
+{
+    this->optimizer->setLearningRate(newRate);
+}
+/*!
+ * @details Replaces the optimizer used by learn, the default is SGD with a rate of 0.25. Throws std::invalid_argument if
+ * newOptimizer is empty.
+ */
+void NeuralNet::setOptimizer(std::shared_ptr<Optimizer> newOptimizer)
+{
+    if(!newOptimizer) throw std::invalid_argument("Optimizer must not be empty");
+    this->optimizer = newOptimizer;
 }
 
 
@@ -57,9 +130,48 @@ std::function<double (double)> NeuralNet::returnDsigmoidFunction()
  * @return Matrix<double>, the output of the network.
  */
 Matrix<double> NeuralNet::feedForward(const Matrix<double>& inputs)
+{
+    return feedForwardHidden(Matrix<double>::dot(inputs, this->weights_input_hidden));
+}
+/*!
+ * @details Forward propagation for a sparse input, the first layer only reads the weights of the non zero inputs.
+ * Inputs denser than sparseDensityThreshold are expanded and take the dense path.
+ * @return Matrix<double>, the output of the network.
+ */
+Matrix<double> NeuralNet::feedForward(const SparseMatrix<double>& inputs)
+{
+    if(inputs.density() > this->sparseDensityThreshold)
+    {
+        return feedForward(inputs.toDense());
+    }
+    return feedForwardHidden(SparseMatrix<double>::dot(inputs, this->weights_input_hidden));
+}
+/*!
+ * @details Forward propagation for a batch with one sample per row. Unlike feedForward it leaves the network untouched, so
+ * several threads can predict with the same net at once.
+ * @return Matrix<double>, one row of outputs per input row.
+ */
+Matrix<double> NeuralNet::predict(const Matrix<double>& inputs) const
+{
+    std::function<double (double)> sigmoidFunction = returnSigmoidFunction();
+    Matrix<double> hidden = Matrix<double>::dot(inputs, this->weights_input_hidden);
+    hidden.addRowVector(this->biasHidden);
+    hidden.map(sigmoidFunction);
+
+    Matrix<double> output = Matrix<double>::dot(hidden, this->weights_hidden_output);
+    output.addRowVector(this->biasOutput);
+    output.map(sigmoidFunction);
+    return output;
+}
+/*!
+ * @details Rest of the forward propagation once the input has been multiplied by the first layer weights.
+ * @param hiddenSum input * weights_input_hidden
+ * @return Matrix<double>, the output of the network.
+ */
+Matrix<double> NeuralNet::feedForwardHidden(Matrix<double> hiddenSum)
 {
     std::function<double (double)> sigmoidFunction = returnSigmoidFunction();
-    this->H = Matrix<double>::dot(inputs, this->weights_input_hidden);
+    this->H = hiddenSum;
     H.elementWiseAddMatrix(this->biasHidden);
     H.map(sigmoidFunction);
 
@@ -73,11 +185,144 @@ Matrix<double> NeuralNet::feedForward(const Matrix<double>& inputs)
  *
  */
 void NeuralNet::learn(Matrix<double>& input,Matrix<double>& outputs)
+{
+    Matrix<double> DJdb1, DJdb2, DJdw2;
+    backpropagate(Matrix<double>::dot(input,this->weights_input_hidden), outputs, DJdb1, DJdb2, DJdw2);
+
+    //computes derivitive of the loss function with respect to the weights of the input layer
+    Matrix<double> DJdw1 = Matrix<double>::dot(input,DJdb1, true, false);
+
+    //adjust the weights
+    this->optimizer->beginStep();
+    this->optimizer->update(inputHiddenSlot, this->weights_input_hidden, DJdw1);
+    this->optimizer->update(hiddenOutputSlot, this->weights_hidden_output, DJdw2);
+    this->optimizer->update(biasHiddenSlot, this->biasHidden, DJdb1);
+    this->optimizer->update(biasOutputSlot, this->biasOutput, DJdb2);
+    if(this->inputHiddenMask.getRows() == 0) return;
+    if(!this->optimizer->isStateless())
+    {
+        applyPruningMask();
+        return;
+    }
+    // plain SGD only moves the weights of inputs that are non zero somewhere in the batch
+    std::vector<int> touched;
+    for(int k = 0; k < input.getColumns(); k++)
+    {
+        for(int s = 0; s < input.getRows(); s++)
+        {
+            if(input.rowPointer(s)[k] != 0)
+            {
+                touched.push_back(k);
+                break;
+            }
+        }
+    }
+    applyPruningMask(touched);
+}
+/*!
+ * @details Same as the dense learn, but the input layer weight gradient is a sparse outer product. With a stateless
+ * optimizer it is applied in place and only the weights of the non zero inputs are touched, otherwise it is expanded
+ * for the optimizer. Inputs denser than sparseDensityThreshold take the dense path.
+ */
+void NeuralNet::learn(const SparseMatrix<double>& input,Matrix<double>& outputs)
+{
+    if(input.density() > this->sparseDensityThreshold)
+    {
+        Matrix<double> denseInput = input.toDense();
+        learn(denseInput, outputs);
+        return;
+    }
+    Matrix<double> DJdb1, DJdb2, DJdw2;
+    backpropagate(SparseMatrix<double>::dot(input,this->weights_input_hidden), outputs, DJdb1, DJdb2, DJdw2);
+
+    this->optimizer->beginStep();
+    if(this->optimizer->isStateless())
+    {
+        SparseMatrix<double>::subtractScaledTransposeDot(this->weights_input_hidden, input, DJdb1, this->optimizer->currentRate());
+    }
+    else
+    {
+        Matrix<double> DJdw1 = SparseMatrix<double>::transposeDot(input, DJdb1);
+        this->optimizer->update(inputHiddenSlot, this->weights_input_hidden, DJdw1);
+    }
+    this->optimizer->update(hiddenOutputSlot, this->weights_hidden_output, DJdw2);
+    this->optimizer->update(biasHiddenSlot, this->biasHidden, DJdb1);
+    this->optimizer->update(biasOutputSlot, this->biasOutput, DJdb2);
+    if(this->optimizer->isStateless())
+    {
+        applyPruningMask(input.nonZeroColumns());
+    }
+    else
+    {
+        applyPruningMask();
+    }
+}
+/*!
+ * @details Magnitude prunes the input layer weights, the fraction sparsity of blockRows x blockCols tiles with the smallest
+ * mean magnitude is zeroed. The tile shape is recorded for PrunedNet. The mask is kept, so further calls to learn fine tune the remaining weights while the pruned
+ * ones stay zero, until clearPruningMask is called.
+ */
+void NeuralNet::pruneInputLayer(double sparsity, int blockRows, int blockCols)
+{
+    this->inputHiddenMask = pruneToSparsity(this->weights_input_hidden, sparsity, blockRows, blockCols);
+    this->pruneBlockRows = blockRows;
+    this->pruneBlockCols = blockCols;
+}
+/*!
+ * @details Same as pruneInputLayer, but zeroes every tile whose mean magnitude is below threshold.
+ */
+void NeuralNet::pruneInputLayerThreshold(double threshold, int blockRows, int blockCols)
+{
+    this->inputHiddenMask = pruneByThreshold(this->weights_input_hidden, threshold, blockRows, blockCols);
+    this->pruneBlockRows = blockRows;
+    this->pruneBlockCols = blockCols;
+}
+/*!
+ * @details Re-zeroes the pruned input layer weights after an update, does nothing if the layer was not pruned.
+ */
+void NeuralNet::applyPruningMask()
+{
+    std::vector<int> rows(this->inputHiddenMask.getRows());
+    for(int i = 0; i < static_cast<int>(rows.size()); i++)
+    {
+        rows[i] = i;
+    }
+    applyPruningMask(rows);
+}
+/*!
+ * @details Re-zeroes the pruned weights of the given input layer rows only, for updates that left the other rows alone.
+ * @param rows input indices whose weights the update changed
+ */
+void NeuralNet::applyPruningMask(const std::vector<int>& rows)
+{
+    if(this->inputHiddenMask.getRows() == 0) return;
+    const int columns = this->hidden_nodes;
+    for(int i : rows)
+    {
+        const double* maskRow = this->inputHiddenMask.rowPointer(i);
+        double* row = this->weights_input_hidden.rowPointer(i);
+        for(int j = 0; j < columns; j++)
+        {
+            row[j] *= maskRow[j];
+        }
+    }
+}
+/*!
+ * @details Shared part of learn, computes the derivitives of the loss for everything except the input layer weights,
+ * which the caller derives from DJdb1.
+ * @param hiddenSum input * weights_input_hidden
+ * @param outputs expected output
+ * @param DJdb1 set to the derivitive of the loss function with respect to the hidden bias
+ * @param DJdb2 set to the derivitive of the loss function with respect to the output bias
+ * @param DJdw2 set to the derivitive of the loss function with respect to the output layer weights
+ */
+void NeuralNet::backpropagate(Matrix<double> hiddenSum, Matrix<double>& outputs,
+                              Matrix<double>& DJdb1, Matrix<double>& DJdb2, Matrix<double>& DJdw2)
 {
     std::function<double (double)> sigmoidFunction = returnDsigmoidFunction();
 
     //computes the derivitive of the loss function with respect to the bias, output layer
-    Matrix<double> DJdb2 = Matrix<double>::subtract(this->Y, outputs);
+    DJdb2 = Matrix<double>::subtract(this->Y, outputs);
     Matrix<double> temp = Matrix<double>::dot(this->H, this->weights_hidden_output);
     temp.elementWiseAddMatrix(this->biasOutput);
     temp.map(sigmoidFunction);
@@ -85,36 +330,15 @@ void NeuralNet::learn(Matrix<double>& input,Matrix<double>& outputs)
 
 
     //computes the derivitive of the loss function with respect to the bias, input layer
-    Matrix<double> weightT = Matrix<double>::transpose(this->weights_hidden_output);
-    Matrix<double> temp2 = Matrix<double>::dot(input,this->weights_input_hidden);
-    temp2.elementWiseAddMatrix(this->biasHidden);
-    temp2.map(sigmoidFunction);
-    Matrix<double> DJdb1 = Matrix<double>::dot(DJdb2,weightT);
-    DJdb1.elementWiseMultiplyMatrix(temp2);
+    hiddenSum.elementWiseAddMatrix(this->biasHidden);
+    hiddenSum.map(sigmoidFunction);
+    DJdb1 = Matrix<double>::dot(DJdb2,this->weights_hidden_output, false, true);
+    DJdb1.elementWiseMultiplyMatrix(hiddenSum);
 
     //computes derivitive of the loss function with respect to the weights of the output layer
-    Matrix<double> DJdw2 = Matrix<double>::transpose(this->H);
-    DJdw2 = Matrix<double>::dot(DJdw2,DJdb2);
-
-
-    //computes derivitive of the loss function with respect to the weights of the input layer
-    Matrix<double> inputT = Matrix<double>::transpose(input);
-    Matrix<double> DJdw1 = Matrix<double>::dot(inputT,DJdb1);
-    
-    //scale the derivitives by the learning rate
-    DJdw1.elementWiseMulitpyScalar(this->learningRate);
-    DJdw2.elementWiseMulitpyScalar(this->learningRate);
-    DJdb1.elementWiseMulitpyScalar(this->learningRate);
-    DJdb2.elementWiseMulitpyScalar(this->learningRate);
-    
-    //adjust the weights
-    this->weights_input_hidden = Matrix<double>::subtract(this->weights_input_hidden, DJdw1);
-    this->weights_hidden_output = Matrix<double>::subtract(this->weights_hidden_output, DJdw2);
-    this->biasHidden = Matrix<double>::subtract(this->biasHidden, DJdb1);
-    this->biasOutput = Matrix<double>::subtract(this->biasOutput, DJdb2);
+    DJdw2 = Matrix<double>::dot(this->H,DJdb2, true, false);
 }
 
-
 void NeuralNet::saveModel()
 {
     //TODO: Account for little endian and big endian machines 
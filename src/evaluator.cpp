@@ -0,0 +1,243 @@
+//
+//  evaluator.cpp
+//  Neural Net
+//
+//  Batched, multi threaded evaluation of a NeuralNet on a labelled data set.
+//
+
+#include "evaluator.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+/*
+ * Nearest rank percentile of sorted values, 0 if there are none.
+ */
+static double percentile(const std::vector<double>& sorted, double fraction)
+{
+    if(sorted.empty()) return 0;
+    int index = static_cast<int>(fraction * sorted.size() + 0.5) - 1;
+    index = std::max(0, std::min(index, static_cast<int>(sorted.size()) - 1));
+    return sorted[index];
+}
+
+std::ostream& operator<<(std::ostream& stream, const EvaluationReport& report)
+{
+    stream << "samples: " << report.samples << std::endl;
+    stream << "accuracy: " << report.accuracy << std::endl;
+    stream << "loss: " << report.loss << std::endl;
+    stream << "images/sec: " << report.imagesPerSecond << std::endl;
+    stream << "batch latency ms p50/p90/p99: " << report.latencyP50 << " " << report.latencyP90 << " "
+           << report.latencyP99 << std::endl;
+    stream << "class precision recall" << std::endl;
+    for(int c = 0; c < report.classes; c++)
+    {
+        stream << c << " " << report.precision[c] << " " << report.recall[c] << std::endl;
+    }
+    stream << "confusion (rows actual, columns predicted)" << std::endl;
+    for(int c = 0; c < report.classes; c++)
+    {
+        for(int p = 0; p < report.classes; p++)
+        {
+            stream << report.confusion[c][p] << " ";
+        }
+        stream << std::endl;
+    }
+    return stream;
+}
+
+/*!
+ * @details Throws std::invalid_argument if batchSize is not positive or threads is negative.
+ * @param batchSize rows per predict call
+ * @param threads worker threads, 0 uses every hardware thread
+ */
+Evaluator::Evaluator(int batchSize, int threads)
+{
+    if(batchSize <= 0) throw std::invalid_argument("Batch size must be positive");
+    if(threads < 0) throw std::invalid_argument("Thread count must be non-negative");
+    this->batchSize = batchSize;
+    this->threads = threads;
+}
+/*!
+ * @details Index of the largest value in a row of outputs.
+ */
+int Evaluator::argmax(const Matrix<double>& outputs, int row)
+{
+    const double* values = outputs.rowPointer(row);
+    int best = 0;
+    for(int j = 1; j < outputs.getColumns(); j++)
+    {
+        if(values[j] > values[best]) best = j;
+    }
+    return best;
+}
+/*!
+ * @details Evaluates net on inputs, one sample per row. Throws std::invalid_argument if inputs is not as wide as the input
+ * layer, labels does not have one entry per row or a label is outside the output range.
+ * @param net
+ * @param inputs
+ * @param labels
+ * @return EvaluationReport
+ */
+EvaluationReport Evaluator::evaluate(const NeuralNet& net, const Matrix<double>& inputs, const std::vector<int>& labels) const
+{
+    return evaluatePredictor([&net](const Matrix<double>& batch){return net.predict(batch);}, net.getInputNodes(),
+                             net.getOutputNodes(), inputs, labels);
+}
+/*!
+ * @details Evaluates a pruned net, compare with the report of the NeuralNet it came from to measure the accuracy cost.
+ */
+EvaluationReport Evaluator::evaluate(const PrunedNet& net, const Matrix<double>& inputs, const std::vector<int>& labels) const
+{
+    return evaluatePredictor([&net](const Matrix<double>& batch){return net.predict(batch);}, net.getInputNodes(),
+                             net.getOutputNodes(), inputs, labels);
+}
+/*!
+ * @details Shared evaluation loop. Workers take batches from a shared counter and keep their own counts, which are merged
+ * at the end. Throws std::invalid_argument if the inputs or labels do not fit the net, an exception thrown by predict
+ * stops the remaining batches and is rethrown once every worker has finished.
+ */
+EvaluationReport Evaluator::evaluatePredictor(const std::function<Matrix<double> (const Matrix<double>&)>& predict,
+                                              int inputNodes, int classes, const Matrix<double>& inputs,
+                                              const std::vector<int>& labels) const
+{
+    const int samples = inputs.getRows();
+    if(inputs.getColumns() != inputNodes) throw std::invalid_argument("Input width does not match the net");
+    if(static_cast<int>(labels.size()) != samples) throw std::invalid_argument("Need one label per sample");
+    for(int label : labels)
+    {
+        if(label < 0 || label >= classes) throw std::invalid_argument("Label outside of output range");
+    }
+    const int batches = (samples + this->batchSize - 1) / this->batchSize;
+    int workerCount = this->threads > 0 ? this->threads : static_cast<int>(std::thread::hardware_concurrency());
+    workerCount = std::max(1, std::min(workerCount, batches));
+
+    std::vector<std::vector<std::vector<int> > > confusion(workerCount, std::vector<std::vector<int> >(classes, std::vector<int>(classes, 0)));
+    std::vector<double> loss(workerCount, 0);
+    std::vector<double> latencies(batches, 0);
+    std::atomic<int> nextBatch(0);
+    std::vector<std::exception_ptr> errors(workerCount);
+    const int size = this->batchSize;
+
+    auto evaluateBatches = [&](int worker)
+    {
+        for(int batch = nextBatch.fetch_add(1); batch < batches; batch = nextBatch.fetch_add(1))
+        {
+            const int begin = batch * size;
+            const int end = std::min(samples, begin + size);
+            auto start = std::chrono::steady_clock::now();
+            Matrix<double> outputs = predict(inputs.rowSlice(begin, end));
+            latencies[batch] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            for(int i = 0; i < end - begin; i++)
+            {
+                const int actual = labels[begin + i];
+                confusion[worker][actual][argmax(outputs, i)]++;
+                const double* values = outputs.rowPointer(i);
+                for(int j = 0; j < classes; j++)
+                {
+                    double error = values[j] - (j == actual ? 1 : 0);
+                    loss[worker] += error * error;
+                }
+            }
+        }
+    };
+    auto work = [&](int worker)
+    {
+        try
+        {
+            evaluateBatches(worker);
+        }
+        catch(...)
+        {
+            errors[worker] = std::current_exception();
+            nextBatch.store(batches);
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    const MemoryPolicy policy = MemoryPlacement::currentPolicy();
+    for(int w = 1; w < workerCount; w++)
+    {
+        workers.push_back(std::thread([&work, policy, w]()
+        {
+            MemoryPlacement::startWorker(policy, w);
+            work(w);
+        }));
+    }
+    work(0);
+    for(std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    for(const std::exception_ptr& error : errors)
+    {
+        if(error) std::rethrow_exception(error);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    EvaluationReport report;
+    report.samples = samples;
+    report.classes = classes;
+    report.confusion.assign(classes, std::vector<int>(classes, 0));
+    double totalLoss = 0;
+    for(int w = 0; w < workerCount; w++)
+    {
+        totalLoss += loss[w];
+        for(int c = 0; c < classes; c++)
+        {
+            for(int p = 0; p < classes; p++)
+            {
+                report.confusion[c][p] += confusion[w][c][p];
+            }
+        }
+    }
+    int correct = 0;
+    report.precision.assign(classes, 0);
+    report.recall.assign(classes, 0);
+    for(int c = 0; c < classes; c++)
+    {
+        int predicted = 0;
+        int actual = 0;
+        for(int other = 0; other < classes; other++)
+        {
+            predicted += report.confusion[other][c];
+            actual += report.confusion[c][other];
+        }
+        correct += report.confusion[c][c];
+        report.precision[c] = predicted == 0 ? 0 : static_cast<double>(report.confusion[c][c]) / predicted;
+        report.recall[c] = actual == 0 ? 0 : static_cast<double>(report.confusion[c][c]) / actual;
+    }
+    report.accuracy = samples == 0 ? 0 : static_cast<double>(correct) / samples;
+    report.loss = samples == 0 ? 0 : totalLoss / samples;
+    report.imagesPerSecond = seconds > 0 ? samples / seconds : 0;
+    std::sort(latencies.begin(), latencies.end());
+    report.latencyP50 = percentile(latencies, 0.50);
+    report.latencyP90 = percentile(latencies, 0.90);
+    report.latencyP99 = percentile(latencies, 0.99);
+    return report;
+}
+/*!
+ * @details Evaluates a snapshot of the weights and biases of net on a background thread, training can keep updating the
+ * original meanwhile. Only those four matrices are copied, once, the optimizer state and activations are left behind.
+ * inputs and labels are not copied and must stay alive and unchanged until the future is ready.
+ * @return std::future holding the EvaluationReport.
+ */
+std::future<EvaluationReport> Evaluator::evaluateAsync(const NeuralNet& net, const Matrix<double>& inputs,
+                                                       const std::vector<int>& labels) const
+{
+    Evaluator evaluator = *this;
+    std::shared_ptr<const NeuralNet> snapshot = std::make_shared<const NeuralNet>(net.getWeightsInputHidden(),
+                                                                                  net.getWeightsHiddenOutput(),
+                                                                                  net.getBiasHidden(), net.getBiasOutput());
+    const Matrix<double>* inputData = &inputs;
+    const std::vector<int>* labelData = &labels;
+    return std::async(std::launch::async, [evaluator, snapshot, inputData, labelData]()
+    {
+        return evaluator.evaluate(*snapshot, *inputData, *labelData);
+    });
+}
@@ -10,11 +10,13 @@
 #include "matrix.h"
 #include "NeuralNet.h"
 #include "dataParser.h"
+#include "evaluator.h"
 
 int main(int argc, const char * argv[])
 {
     NeuralNet nn(784,10,10);
-    Matrix<double> dataMatrix = returnMatrixData("/Users/Eddie_g/Library/Autosave Information/Neural_Net/Neural_Net/data0");
+    const std::string dataPath = "/Users/Eddie_g/Library/Autosave Information/Neural_Net/Neural_Net/data";
+    Matrix<double> dataMatrix = returnMatrixData(dataPath + "0");
     int answer;
     std::cout << "Handwritten digit classifier!" << std::endl;
     std::cout << "Would you like to train a new model, or load up a previously trained model?" << std::endl;
@@ -46,10 +48,23 @@ int main(int argc, const char * argv[])
             int number;
             std::cout << "What number would you like to classify?(0-9)" << std::endl;
             std::cin >> number;
+            if(number < 0 || number > 9)
+            {
+                std::cout << "Not a digit." << std::endl;
+                return 1;
+            }
             std::cout << std::endl << "The program will choose a random example from 300 different images." << std::endl;
-            Matrix<double> testData = dataMatrix[1];
+            // the last 300 images of each file are never trained on
+            Matrix<double> digitData = returnMatrixData(dataPath + std::to_string(number));
+            std::srand(static_cast<unsigned>(std::time(nullptr)));
+            Matrix<double> testData = digitData[700 + std::rand() % 300];
             Matrix<double> prediction = nn.feedForward(testData);
             std::cout << prediction <<std::endl;
+            std::cout << "Predicted digit: " << Evaluator::argmax(prediction, 0) << std::endl << std::endl;
+
+            Evaluator evaluator;
+            std::vector<int> labels(300, number);
+            std::cout << evaluator.evaluate(nn, digitData.rowSlice(700, 1000), labels) << std::endl;
             
         }
     }
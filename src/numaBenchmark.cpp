@@ -0,0 +1,193 @@
+//
+//  numaBenchmark.cpp
+//  Neural Net
+//
+//  Compares training with default placement against a net and data set placed on one NUMA node.
+//
+//  usage: numa_bench [memoryNode] [cpuNode] [hiddenNodes] [samples]
+//  In the placed run every buffer of at least MemoryPlacement::minimumMappedBytes (the data set, the input layer
+//  weights and its gradient) is bound to memoryNode with transparent huge pages, and every thread runs on cpuNode. With
+//  memoryNode != cpuNode those buffers are remote, smaller temporaries stay local to the thread that touches them. The
+//  placement the kernel actually gave the data set and the weights is read back from /proc/self/numa_maps and smaps and
+//  printed with the timings.
+//
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "matrix.h"
+#include "NeuralNet.h"
+#include "evaluator.h"
+#include "numaPlacement.h"
+#include "randomGenerator.h"
+
+struct BenchmarkResult
+{
+    double setup; /*!< Milliseconds to create the data set and the net */
+    double train; /*!< Milliseconds for one pass of single sample training steps */
+    double evaluate; /*!< Milliseconds for a batched evaluation of the data set */
+    double accuracy;
+    std::string dataPlacement; /*!< numa_maps entry of the data set buffer */
+    std::string weightPlacement; /*!< numa_maps entry of the input layer weights */
+};
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*
+ * numa_maps entry (policy and pages per node) and AnonHugePages of the mapping holding address, empty if there is none.
+ */
+static std::string describeMapping(const void* address)
+{
+    const std::uintptr_t target = reinterpret_cast<std::uintptr_t>(address);
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    std::string start;
+    while(std::getline(maps, line))
+    {
+        std::size_t dash = line.find('-');
+        std::uintptr_t begin = std::stoull(line.substr(0, dash), nullptr, 16);
+        std::uintptr_t end = std::stoull(line.substr(dash + 1, line.find(' ') - dash - 1), nullptr, 16);
+        if(target >= begin && target < end)
+        {
+            start = line.substr(0, dash);
+            break;
+        }
+    }
+    if(start.empty()) return "";
+
+    std::string description;
+    std::ifstream numaMaps("/proc/self/numa_maps");
+    while(std::getline(numaMaps, line))
+    {
+        if(line.compare(0, start.size() + 1, start + " ") == 0)
+        {
+            description = line.substr(start.size() + 1);
+            break;
+        }
+    }
+    // smaps lists the fields of each mapping after its header line
+    std::ifstream smaps("/proc/self/smaps");
+    bool inMapping = false;
+    while(std::getline(smaps, line))
+    {
+        if(line.find('-') != std::string::npos && line.find(':') > line.find(' ')) inMapping = line.compare(0, start.size() + 1, start + "-") == 0;
+        if(inMapping && line.compare(0, 14, "AnonHugePages:") == 0)
+        {
+            std::stringstream fields(line.substr(14));
+            std::string kilobytes;
+            fields >> kilobytes;
+            description += " AnonHugePages=" + kilobytes + "kB";
+            break;
+        }
+    }
+    return description;
+}
+/*
+ * True if every page of a numa_maps entry is on node, false if a page is elsewhere or none is listed.
+ */
+static bool pagesOnNode(const std::string& description, int node)
+{
+    std::stringstream fields(description);
+    std::string field;
+    bool found = false;
+    while(fields >> field)
+    {
+        if(field.size() < 3 || field[0] != 'N' || field.find('=') == std::string::npos) continue;
+        if(std::atoi(field.c_str() + 1) != node) return false;
+        found = true;
+    }
+    return found;
+}
+
+/*!
+ * @details Creates a random data set and a net on the calling thread, trains for one pass and evaluates. Every buffer is
+ * created under the calling thread's MemoryPolicy.
+ */
+static BenchmarkResult runBenchmark(int hiddenNodes, int samples)
+{
+    const int inputNodes = 784;
+    const int outputNodes = 10;
+    BenchmarkResult result;
+    CounterRandom::setGlobalSeed(1);
+
+    auto start = std::chrono::steady_clock::now();
+    Matrix<double> inputs(samples, inputNodes);
+    inputs.randomizeUniform(0, 1);
+    std::vector<int> labels(samples);
+    std::vector<Matrix<double> > targets;
+    for(int i = 0; i < samples; i++)
+    {
+        labels[i] = i % outputNodes;
+        Matrix<double> target(1, outputNodes);
+        target.set(0, labels[i], 1);
+        targets.push_back(target);
+    }
+    NeuralNet net(inputNodes, hiddenNodes, outputNodes);
+    result.setup = millisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for(int i = 0; i < samples; i++)
+    {
+        Matrix<double> row = inputs.rowSlice(i, i + 1);
+        net.feedForward(row);
+        net.learn(row, targets[i]);
+    }
+    result.train = millisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    Evaluator evaluator;
+    result.accuracy = evaluator.evaluate(net, inputs, labels).accuracy;
+    result.evaluate = millisecondsSince(start);
+
+    result.dataPlacement = describeMapping(inputs.rowPointer(0));
+    result.weightPlacement = describeMapping(net.getWeightsInputHidden().rowPointer(0));
+    return result;
+}
+
+static void printResult(const std::string& name, const BenchmarkResult& result)
+{
+    std::cout << name << ": setup " << result.setup << "ms, train " << result.train << "ms, evaluate "
+              << result.evaluate << "ms, accuracy " << result.accuracy << std::endl;
+    std::cout << "  data set: " << result.dataPlacement << std::endl;
+    std::cout << "  weights:  " << result.weightPlacement << std::endl;
+}
+
+int main(int argc, const char * argv[])
+{
+    int memoryNode = argc > 1 ? std::atoi(argv[1]) : 0;
+    int cpuNode = argc > 2 ? std::atoi(argv[2]) : memoryNode;
+    int hiddenNodes = argc > 3 ? std::atoi(argv[3]) : 256;
+    int samples = argc > 4 ? std::atoi(argv[4]) : 2000;
+    if(memoryNode < 0 || cpuNode < 0 || hiddenNodes <= 0 || samples <= 0)
+    {
+        std::cout << "usage: numa_bench [memoryNode] [cpuNode] [hiddenNodes] [samples]" << std::endl;
+        return 1;
+    }
+    std::cout << MemoryPlacement::nodeCount() << " NUMA node(s), memory on node " << memoryNode << ", threads on node "
+              << cpuNode << std::endl;
+
+    printResult("default", runBenchmark(hiddenNodes, samples));
+
+    BenchmarkResult placed;
+    MemoryPlacement::setPinWorkers(true);
+    MemoryPlacement::runOnNode(cpuNode, HugePageMode::transparentHugePages, [&]()
+    {
+        ScopedPlacement placement(memoryNode, HugePageMode::transparentHugePages);
+        placed = runBenchmark(hiddenNodes, samples);
+    });
+    MemoryPlacement::setPinWorkers(false);
+    printResult("placed", placed);
+
+    bool bound = pagesOnNode(placed.dataPlacement, memoryNode) && pagesOnNode(placed.weightPlacement, memoryNode);
+    std::cout << "placed buffers " << (bound ? "are" : "are NOT") << " all on node " << memoryNode << ", "
+              << MemoryPlacement::unmapFailures() << " failed unmaps" << std::endl;
+    return bound ? 0 : 2;
+}
@@ -0,0 +1,216 @@
+//
+//  optimizer.cpp
+//  Neural Net
+//
+//  Gradient descent optimizers and learning rate schedules.
+//
+
+#include "optimizer.h"
+#include <cmath>
+#include <stdexcept>
+
+double ConstantSchedule::rate(double baseRate, int step) const
+{
+    return baseRate;
+}
+
+StepDecaySchedule::StepDecaySchedule(int stepSize, double gamma)
+{
+    if(stepSize <= 0) throw std::invalid_argument("Step size must be positive");
+    this->stepSize = stepSize;
+    this->gamma = gamma;
+}
+
+double StepDecaySchedule::rate(double baseRate, int step) const
+{
+    return baseRate * std::pow(this->gamma, (step - 1) / this->stepSize);
+}
+
+ExponentialDecaySchedule::ExponentialDecaySchedule(double decay)
+{
+    this->decay = decay;
+}
+
+double ExponentialDecaySchedule::rate(double baseRate, int step) const
+{
+    return baseRate * std::pow(this->decay, step - 1);
+}
+
+InverseTimeSchedule::InverseTimeSchedule(double decay)
+{
+    this->decay = decay;
+}
+
+double InverseTimeSchedule::rate(double baseRate, int step) const
+{
+    return baseRate / (1 + this->decay * (step - 1));
+}
+
+Optimizer::Optimizer(double learningRate)
+{
+    this->learningRate = learningRate;
+    this->rate = learningRate;
+    this->step = 0;
+    this->schedule = std::make_shared<ConstantSchedule>();
+}
+/*!
+ * @details Starts a new training step, advances the step counter and evaluates the schedule for it.
+ */
+void Optimizer::beginStep()
+{
+    this->step++;
+    this->rate = this->schedule->rate(this->learningRate, this->step);
+}
+/*!
+ * @details Replaces the learning rate schedule, throws std::invalid_argument if newSchedule is empty.
+ * @param newSchedule
+ */
+void Optimizer::setSchedule(std::shared_ptr<LearningRateSchedule> newSchedule)
+{
+    if(!newSchedule) throw std::invalid_argument("Schedule must not be empty");
+    this->schedule = newSchedule;
+}
+/*!
+ * @details Returns the state Matrix of a slot, creating it zero filled with the shape of param on first use.
+ * @param state one Matrix per slot
+ * @param slot
+ * @param param
+ * @return Matrix<double>&, state of the slot.
+ */
+Matrix<double>& Optimizer::stateFor(std::vector<Matrix<double> >& state, int slot, const Matrix<double>& param)
+{
+    if(slot < 0) throw std::out_of_range("Optimizer slot must be non-negative");
+    if(static_cast<int>(state.size()) <= slot) state.resize(slot + 1);
+    Matrix<double>& current = state[slot];
+    if(current.getRows() != param.getRows() || current.getColumns() != param.getColumns())
+    {
+        current = Matrix<double>(param.getRows(), param.getColumns());
+    }
+    return current;
+}
+/*!
+ * @details Throws std::invalid_argument if param and grad differ in shape.
+ */
+void Optimizer::validateGradient(const Matrix<double>& param, const Matrix<double>& grad)
+{
+    if(param.getRows() != grad.getRows() || param.getColumns() != grad.getColumns())
+    {
+        throw std::invalid_argument("Gradient dims do not match parameter");
+    }
+}
+
+SGD::SGD(double learningRate):Optimizer(learningRate){}
+
+void SGD::update(int slot, Matrix<double>& param, const Matrix<double>& grad)
+{
+    validateGradient(param, grad);
+    const double rate = currentRate();
+    const int cols = param.getColumns();
+    for(int i = 0; i < param.getRows(); i++)
+    {
+        double* p = param.rowPointer(i);
+        const double* g = grad.rowPointer(i);
+        for(int j = 0; j < cols; j++)
+        {
+            p[j] -= rate * g[j];
+        }
+    }
+}
+
+Momentum::Momentum(double learningRate, double momentum, bool nesterov):Optimizer(learningRate)
+{
+    this->momentum = momentum;
+    this->nesterov = nesterov;
+}
+
+void Momentum::update(int slot, Matrix<double>& param, const Matrix<double>& grad)
+{
+    validateGradient(param, grad);
+    Matrix<double>& state = stateFor(this->velocity, slot, param);
+    const double rate = currentRate();
+    const double mu = this->momentum;
+    // nesterov steps along grad + mu * v, plain momentum along v = 0 * grad + 1 * v
+    const double gradWeight = this->nesterov ? 1 : 0;
+    const double velocityWeight = this->nesterov ? mu : 1;
+    const int cols = param.getColumns();
+    for(int i = 0; i < param.getRows(); i++)
+    {
+        double* p = param.rowPointer(i);
+        const double* g = grad.rowPointer(i);
+        double* v = state.rowPointer(i);
+        for(int j = 0; j < cols; j++)
+        {
+            const double newVelocity = mu * v[j] + g[j];
+            v[j] = newVelocity;
+            p[j] -= rate * (gradWeight * g[j] + velocityWeight * newVelocity);
+        }
+    }
+}
+
+RMSProp::RMSProp(double learningRate, double decay, double epsilon):Optimizer(learningRate)
+{
+    this->decay = decay;
+    this->epsilon = epsilon;
+}
+
+void RMSProp::update(int slot, Matrix<double>& param, const Matrix<double>& grad)
+{
+    validateGradient(param, grad);
+    Matrix<double>& state = stateFor(this->meanSquare, slot, param);
+    const double rate = currentRate();
+    const double rho = this->decay;
+    const double eps = this->epsilon;
+    const int cols = param.getColumns();
+    for(int i = 0; i < param.getRows(); i++)
+    {
+        double* p = param.rowPointer(i);
+        const double* g = grad.rowPointer(i);
+        double* s = state.rowPointer(i);
+        for(int j = 0; j < cols; j++)
+        {
+            const double newMean = rho * s[j] + (1 - rho) * g[j] * g[j];
+            s[j] = newMean;
+            p[j] -= rate * g[j] / (std::sqrt(newMean) + eps);
+        }
+    }
+}
+
+Adam::Adam(double learningRate, double beta1, double beta2, double epsilon):Optimizer(learningRate)
+{
+    this->beta1 = beta1;
+    this->beta2 = beta2;
+    this->epsilon = epsilon;
+}
+/*!
+ * @details The bias corrections only depend on the step, so they are folded into one step size up front and the inner
+ * loop is a single pass over param, grad and both moments.
+ */
+void Adam::update(int slot, Matrix<double>& param, const Matrix<double>& grad)
+{
+    validateGradient(param, grad);
+    Matrix<double>& m = stateFor(this->firstMoment, slot, param);
+    Matrix<double>& v = stateFor(this->secondMoment, slot, param);
+    const int t = getStep() > 0 ? getStep() : 1;
+    const double correction1 = 1 - std::pow(this->beta1, t);
+    const double correction2 = 1 - std::pow(this->beta2, t);
+    const double stepSize = currentRate() * std::sqrt(correction2) / correction1;
+    const double eps = this->epsilon * std::sqrt(correction2);
+    const double b1 = this->beta1;
+    const double b2 = this->beta2;
+    const int cols = param.getColumns();
+    for(int i = 0; i < param.getRows(); i++)
+    {
+        double* p = param.rowPointer(i);
+        const double* g = grad.rowPointer(i);
+        double* mRow = m.rowPointer(i);
+        double* vRow = v.rowPointer(i);
+        for(int j = 0; j < cols; j++)
+        {
+            const double newM = b1 * mRow[j] + (1 - b1) * g[j];
+            const double newV = b2 * vRow[j] + (1 - b2) * g[j] * g[j];
+            mRow[j] = newM;
+            vRow[j] = newV;
+            p[j] -= stepSize * newM / (std::sqrt(newV) + eps);
+        }
+    }
+}
@@ -0,0 +1,167 @@
+//
+//  pruneBenchmark.cpp
+//  Neural Net
+//
+//  Trains a net, prunes and fine tunes its input layer, converts it to a PrunedNet and reports accuracy, model file size
+//  and latency before and after.
+//
+//  usage: prune_bench [sparsity] [fineTuneEpochs] [dataPath]
+//  dataPath is the prefix of the digit files (dataPath + "0" to dataPath + "9"), the first 700 digits of each file are
+//  trained on and the last 300 evaluated. Without it a synthetic data set of noisy class prototypes is used.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "matrix.h"
+#include "NeuralNet.h"
+#include "dataParser.h"
+#include "evaluator.h"
+#include "prunedNet.h"
+#include "randomGenerator.h"
+
+/*!
+ * @details Rows of a data set and their class labels.
+ */
+struct LabelledData
+{
+    Matrix<double> inputs;
+    std::vector<int> labels;
+};
+
+/*
+ * Rows [begin, end) of every digit file, in digit order.
+ */
+static LabelledData loadDigits(const std::string& dataPath, int begin, int end)
+{
+    LabelledData data;
+    data.inputs = Matrix<double>(10 * (end - begin), pixelsPerImage);
+    for(int digit = 0; digit < 10; digit++)
+    {
+        Matrix<double> digits = returnMatrixData(dataPath + std::to_string(digit));
+        for(int i = begin; i < end; i++)
+        {
+            const int row = digit * (end - begin) + i - begin;
+            std::copy(digits.rowPointer(i), digits.rowPointer(i) + pixelsPerImage, data.inputs.rowPointer(row));
+            data.labels.push_back(digit);
+        }
+    }
+    return data;
+}
+/*
+ * samples digit sized images per class. Each class owns a fixed fifth of the pixels, a sample lights each of those with
+ * probability 0.2 and every other pixel with probability 0.05. The classes overlap, so pruning has a visible cost.
+ */
+static LabelledData syntheticDigits(int samples, std::uint64_t stream)
+{
+    const CounterRandom prototypes(7, 0);
+    const CounterRandom noise(7, stream);
+    LabelledData data;
+    data.inputs = Matrix<double>(10 * samples, pixelsPerImage);
+    for(int row = 0; row < 10 * samples; row++)
+    {
+        const int label = row % 10;
+        double* pixels = data.inputs.rowPointer(row);
+        for(int k = 0; k < pixelsPerImage; k++)
+        {
+            const std::uint64_t counter = static_cast<std::uint64_t>(row) * pixelsPerImage + k;
+            const bool lit = prototypes.uniform(static_cast<std::uint64_t>(label) * pixelsPerImage + k) < 0.2;
+            const double draw = noise.uniform(counter);
+            if((lit && draw < 0.2) || (!lit && draw < 0.05)) pixels[k] = 0.5 + 0.5 * noise.uniform(counter + (1ULL << 40));
+        }
+        data.labels.push_back(label);
+    }
+    return data;
+}
+/*
+ * One pass of single sample training in a shuffled order.
+ */
+static void trainEpoch(NeuralNet& net, const LabelledData& data, std::vector<int>& order)
+{
+    for(int i = static_cast<int>(order.size()) - 1; i > 0; i--)
+    {
+        std::swap(order[i], order[std::rand() % (i + 1)]);
+    }
+    for(int sample : order)
+    {
+        Matrix<double> row = data.inputs.rowSlice(sample, sample + 1);
+        Matrix<double> target(1, net.getOutputNodes());
+        target.set(0, data.labels[sample], 1);
+        net.feedForward(row);
+        net.learn(row, target);
+    }
+}
+/*
+ * Writes model to fileName and returns the file size in bytes, the file is removed again.
+ */
+static long modelFileSize(const PrunedNet& model, const std::string& fileName)
+{
+    model.saveModel(fileName);
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    long size = static_cast<long>(file.tellg());
+    file.close();
+    std::remove(fileName.c_str());
+    return size;
+}
+
+static void printRow(const std::string& stage, const EvaluationReport& report, double density, long fileSize)
+{
+    std::cout << std::left << std::setw(22) << stage << std::right << std::fixed << std::setprecision(4)
+              << std::setw(10) << report.accuracy << std::setw(10) << density << std::setprecision(3)
+              << std::setw(12) << report.latencyP50 << std::setprecision(0) << std::setw(14) << report.imagesPerSecond;
+    if(fileSize >= 0) std::cout << std::setw(12) << fileSize;
+    std::cout << std::endl;
+}
+
+int main(int argc, const char * argv[])
+{
+    double sparsity = argc > 1 ? std::atof(argv[1]) : 0.9;
+    int fineTuneEpochs = argc > 2 ? std::atoi(argv[2]) : 2;
+    if(sparsity < 0 || sparsity > 1 || fineTuneEpochs < 0)
+    {
+        std::cout << "usage: prune_bench [sparsity] [fineTuneEpochs] [dataPath]" << std::endl;
+        return 1;
+    }
+    std::srand(1);
+    CounterRandom::setGlobalSeed(1);
+    LabelledData train = argc > 3 ? loadDigits(argv[3], 0, 700) : syntheticDigits(700, 1);
+    LabelledData test = argc > 3 ? loadDigits(argv[3], 700, 1000) : syntheticDigits(300, 2);
+    std::vector<int> order(train.labels.size());
+    for(int i = 0; i < static_cast<int>(order.size()); i++)
+    {
+        order[i] = i;
+    }
+
+    NeuralNet net(pixelsPerImage, 32, 10);
+    for(int epoch = 0; epoch < 3; epoch++)
+    {
+        trainEpoch(net, train, order);
+    }
+    // one thread so the latencies compare the kernels rather than the scheduling
+    Evaluator evaluator(64, 1);
+    std::cout << std::left << std::setw(22) << "stage" << std::right << std::setw(10) << "accuracy" << std::setw(10)
+              << "density" << std::setw(12) << "p50 ms" << std::setw(14) << "images/sec" << std::setw(12) << "file bytes"
+              << std::endl;
+    // the dense file is the unpruned net in the same format, every tile is stored
+    printRow("dense", evaluator.evaluate(net, test.inputs, test.labels), 1,
+             modelFileSize(PrunedNet(net), "prune_bench_dense.nn"));
+
+    net.pruneInputLayer(sparsity);
+    printRow("pruned", evaluator.evaluate(net, test.inputs, test.labels), 1 - sparsity, -1);
+    for(int epoch = 0; epoch < fineTuneEpochs; epoch++)
+    {
+        trainEpoch(net, train, order);
+    }
+    printRow("fine tuned", evaluator.evaluate(net, test.inputs, test.labels), 1 - sparsity, -1);
+
+    PrunedNet pruned(net);
+    printRow("block sparse", evaluator.evaluate(pruned, test.inputs, test.labels), pruned.inputLayerDensity(),
+             modelFileSize(pruned, "prune_bench_pruned.nn"));
+    return 0;
+}
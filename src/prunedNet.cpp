@@ -0,0 +1,112 @@
+//
+//  prunedNet.cpp
+//  Neural Net
+//
+//  Inference only network with a block sparse input layer.
+//
+
+#include "prunedNet.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+static const char prunedModelMagic[4] = {'N', 'N', 'P', 'R'};
+
+/*
+ * Writes a dense Matrix as its dims followed by the rows, in native byte order.
+ */
+static void writeDense(std::ostream& stream, const Matrix<double>& a)
+{
+    int dims[2] = {a.getRows(), a.getColumns()};
+    stream.write(reinterpret_cast<const char*>(dims), sizeof(dims));
+    for(int i = 0; i < a.getRows(); i++)
+    {
+        stream.write(reinterpret_cast<const char*>(a.rowPointer(i)), a.getColumns() * sizeof(double));
+    }
+}
+/*
+ * Reads a Matrix written by writeDense, throws std::runtime_error on a short or invalid stream.
+ */
+static Matrix<double> readDense(std::istream& stream)
+{
+    int dims[2];
+    stream.read(reinterpret_cast<char*>(dims), sizeof(dims));
+    if(!stream || dims[0] < 0 || dims[1] < 0) throw std::runtime_error("Invalid model file");
+    Matrix<double> a(dims[0], dims[1]);
+    for(int i = 0; i < a.getRows(); i++)
+    {
+        stream.read(reinterpret_cast<char*>(a.rowPointer(i)), a.getColumns() * sizeof(double));
+    }
+    if(!stream) throw std::runtime_error("Invalid model file");
+    return a;
+}
+
+PrunedNet::PrunedNet(){}
+/*!
+ * @details Copies the weights of net, compressing the input layer into tiles of the shape it was pruned with.
+ */
+PrunedNet::PrunedNet(const NeuralNet& net):PrunedNet(net, net.getPruneBlockRows(), net.getPruneBlockCols()){}
+/*!
+ * @details Copies the weights of net, compressing the input layer into blockRows x blockCols tiles.
+ */
+PrunedNet::PrunedNet(const NeuralNet& net, int blockRows, int blockCols)
+{
+    this->weights_input_hidden = BlockSparseMatrix<double>::fromDense(net.getWeightsInputHidden(), blockRows, blockCols);
+    this->weights_hidden_output = net.getWeightsHiddenOutput();
+    this->biasHidden = net.getBiasHidden();
+    this->biasOutput = net.getBiasOutput();
+}
+/*!
+ * @details Forward propagation for a batch with one sample per row, same result as NeuralNet::predict on the pruned net.
+ * @return Matrix<double>, one row of outputs per input row.
+ */
+Matrix<double> PrunedNet::predict(const Matrix<double>& inputs) const
+{
+    std::function<double (double)> sigmoidFunction = NeuralNet::returnSigmoidFunction();
+    Matrix<double> hidden = BlockSparseMatrix<double>::dot(inputs, this->weights_input_hidden);
+    hidden.addRowVector(this->biasHidden);
+    hidden.map(sigmoidFunction);
+
+    Matrix<double> output = Matrix<double>::dot(hidden, this->weights_hidden_output);
+    output.addRowVector(this->biasOutput);
+    output.map(sigmoidFunction);
+    return output;
+}
+/*!
+ * @details Writes the model to fileName, throws std::runtime_error if the file cannot be written.
+ */
+void PrunedNet::saveModel(std::string fileName) const
+{
+    std::ofstream stream(fileName, std::ios::binary);
+    if(!stream) throw std::runtime_error("Cannot open " + fileName);
+    stream.write(prunedModelMagic, sizeof(prunedModelMagic));
+    this->weights_input_hidden.save(stream);
+    writeDense(stream, this->weights_hidden_output);
+    writeDense(stream, this->biasHidden);
+    writeDense(stream, this->biasOutput);
+    if(!stream) throw std::runtime_error("Cannot write " + fileName);
+}
+/*!
+ * @details Replaces this model with one written by saveModel, throws std::runtime_error if the file is missing or invalid.
+ */
+void PrunedNet::loadModel(std::string fileName)
+{
+    std::ifstream stream(fileName, std::ios::binary);
+    if(!stream) throw std::runtime_error("Cannot open " + fileName);
+    char magic[sizeof(prunedModelMagic)];
+    stream.read(magic, sizeof(magic));
+    if(!stream || !std::equal(magic, magic + sizeof(magic), prunedModelMagic)) throw std::runtime_error("Invalid model file");
+    BlockSparseMatrix<double> inputHidden = BlockSparseMatrix<double>::load(stream);
+    Matrix<double> hiddenOutput = readDense(stream);
+    Matrix<double> hiddenBias = readDense(stream);
+    Matrix<double> outputBias = readDense(stream);
+    if(hiddenOutput.getRows() != inputHidden.getColumns() || hiddenBias.getColumns() != inputHidden.getColumns()
+       || outputBias.getColumns() != hiddenOutput.getColumns())
+    {
+        throw std::runtime_error("Invalid model file");
+    }
+    this->weights_input_hidden = inputHidden;
+    this->weights_hidden_output = hiddenOutput;
+    this->biasHidden = hiddenBias;
+    this->biasOutput = outputBias;
+}
@@ -0,0 +1,269 @@
+//
+//  sweep.cpp
+//  Neural Net
+//
+//  Trains many small networks side by side for hyperparameter sweeps.
+//
+
+#include "sweep.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "evaluator.h"
+#include "randomGenerator.h"
+
+std::ostream& operator<<(std::ostream& stream, const SweepResult& result)
+{
+    stream << "hidden " << result.config.hiddenNodes << " rate " << result.config.learningRate << " seed "
+           << result.config.seed << " samples " << result.samples << " loss " << result.loss << " accuracy "
+           << result.accuracy;
+    return stream;
+}
+
+/*
+ * Adds the squared error and the hit of each row of outputs against its label to result.
+ */
+static void scoreOutputs(SweepResult& result, const Matrix<double>& outputs, const std::vector<int>& labels, int firstLabel)
+{
+    for(int i = 0; i < outputs.getRows(); i++)
+    {
+        const int actual = labels[firstLabel + i];
+        const double* values = outputs.rowPointer(i);
+        for(int j = 0; j < outputs.getColumns(); j++)
+        {
+            double error = values[j] - (j == actual ? 1 : 0);
+            result.loss += error * error;
+        }
+        if(Evaluator::argmax(outputs, i) == actual) result.accuracy++;
+    }
+    result.samples += outputs.getRows();
+}
+/*
+ * Turns the summed loss and hits of each result into means.
+ */
+static void finishResults(std::vector<SweepResult>& results)
+{
+    for(SweepResult& result : results)
+    {
+        if(result.samples == 0) continue;
+        result.loss /= result.samples;
+        result.accuracy /= result.samples;
+    }
+}
+
+/*!
+ * @details Sets up one model per config. Each model starts from the weights NeuralNet(inputNodes, hiddenNodes, outputNodes)
+ * gets after CounterRandom::setGlobalSeed(seed): the input layer from stream 0 and the output layer from stream 1 of the
+ * model's seed. They are drawn from local generators, so the global seed and stream position are never touched and
+ * fills on other threads are not affected. Throws std::invalid_argument if there are no configs or a config has no hidden
+ * nodes.
+ */
+SweepRunner::SweepRunner(int inputNodes, int outputNodes, const std::vector<SweepConfig>& configs)
+{
+    if(configs.empty()) throw std::invalid_argument("Sweep needs at least one config");
+    this->inputNodes = inputNodes;
+    this->outputNodes = outputNodes;
+    this->configs = configs;
+    int totalHidden = 0;
+    for(const SweepConfig& config : configs)
+    {
+        if(config.hiddenNodes <= 0) throw std::invalid_argument("Hidden nodes must be positive");
+        this->hiddenOffset.push_back(totalHidden);
+        totalHidden += config.hiddenNodes;
+    }
+    this->weights_input_hidden = Matrix<double>(inputNodes, totalHidden);
+    this->biasHidden = Matrix<double>(1, totalHidden);
+
+    for(std::size_t m = 0; m < configs.size(); m++)
+    {
+        const int offset = this->hiddenOffset[m];
+        const int hidden = configs[m].hiddenNodes;
+        // Matrix::xavierUniform on an inputNodes x hidden Matrix, written straight into the model's column block
+        const CounterRandom inputGenerator(configs[m].seed, 0);
+        const double limit = std::sqrt(6.0 / (inputNodes + hidden));
+        for(int i = 0; i < inputNodes; i++)
+        {
+            double* row = this->weights_input_hidden.rowPointer(i) + offset;
+            const std::uint64_t base = static_cast<std::uint64_t>(i) * hidden;
+            for(int j = 0; j < hidden; j++)
+            {
+                row[j] = -limit + (limit - -limit) * inputGenerator.uniform(base + j);
+            }
+        }
+        Matrix<double> outputWeights(hidden, outputNodes);
+        outputWeights.xavierUniform(CounterRandom(configs[m].seed, 1));
+        this->weights_hidden_output.push_back(outputWeights);
+        this->biasOutput.push_back(Matrix<double>(1, outputNodes));
+    }
+}
+/*!
+ * @details Throws std::invalid_argument unless there is one label per input row, the labels fit the outputs and the batch
+ * size is positive.
+ */
+void SweepRunner::validateData(const Matrix<double>& inputs, const std::vector<int>& labels, int batchSize) const
+{
+    if(batchSize <= 0) throw std::invalid_argument("Batch size must be positive");
+    if(inputs.getColumns() != this->inputNodes) throw std::invalid_argument("Input dims do not match the sweep");
+    if(static_cast<int>(labels.size()) != inputs.getRows()) throw std::invalid_argument("Need one label per sample");
+    for(int label : labels)
+    {
+        if(label < 0 || label >= this->outputNodes) throw std::invalid_argument("Label outside of output range");
+    }
+}
+/*!
+ * @details Hidden layer input of every model for a batch, the single grouped GEMM of the forward pass.
+ * @return Matrix<double>, batch rows x sum of hidden nodes.
+ */
+Matrix<double> SweepRunner::hiddenSum(const Matrix<double>& batch) const
+{
+    Matrix<double> sum = Matrix<double>::dot(batch, this->weights_input_hidden);
+    sum.addRowVector(this->biasHidden);
+    return sum;
+}
+/*!
+ * @details One SGD pass over inputs for every model. Gradients are summed over each batch, with a batch size of 1 every
+ * model follows the same rule as NeuralNet::learn up to rounding, the rate is applied to the gradient before it is
+ * multiplied by the input. Loss and accuracy are measured on each batch before the models
+ * learn from it.
+ * @param inputs one sample per row
+ * @param labels class of each sample
+ * @param batchSize
+ * @return One SweepResult per model.
+ */
+std::vector<SweepResult> SweepRunner::trainEpoch(const Matrix<double>& inputs, const std::vector<int>& labels, int batchSize)
+{
+    validateData(inputs, labels, batchSize);
+    std::function<double (double)> sigmoidFunction = NeuralNet::returnSigmoidFunction();
+    std::function<double (double)> dSigmoidFunction = NeuralNet::returnDsigmoidFunction();
+    std::vector<SweepResult> results(this->configs.size(), SweepResult());
+    const int totalHidden = this->weights_input_hidden.getColumns();
+
+    for(int begin = 0; begin < inputs.getRows(); begin += batchSize)
+    {
+        const int end = std::min(inputs.getRows(), begin + batchSize);
+        Matrix<double> batch = inputs.rowSlice(begin, end);
+        Matrix<double> targets(end - begin, this->outputNodes);
+        for(int i = begin; i < end; i++)
+        {
+            targets.set(i - begin, labels[i], 1);
+        }
+        Matrix<double> hidden = hiddenSum(batch);
+        Matrix<double> hiddenSlope = Matrix<double>::map(hidden, dSigmoidFunction);
+        hidden.map(sigmoidFunction);
+        Matrix<double> DJdb1(end - begin, totalHidden); // scaled by each model's rate
+
+        for(int m = 0; m < models(); m++)
+        {
+            const int offset = this->hiddenOffset[m];
+            const int width = this->configs[m].hiddenNodes;
+            const double rate = this->configs[m].learningRate;
+            Matrix<double> H = hidden.columnSlice(offset, offset + width);
+
+            Matrix<double> Y = Matrix<double>::dot(H, this->weights_hidden_output[m]);
+            Y.addRowVector(this->biasOutput[m]);
+            Matrix<double> outputSlope = Matrix<double>::map(Y, dSigmoidFunction);
+            Y.map(sigmoidFunction);
+            scoreOutputs(results[m], Y, labels, begin);
+
+            Matrix<double> DJdb2 = Matrix<double>::subtract(Y, targets);
+            DJdb2.elementWiseMultiplyMatrix(outputSlope);
+            Matrix<double> modelDJdb1 = Matrix<double>::dot(DJdb2, this->weights_hidden_output[m], false, true);
+            modelDJdb1.elementWiseMultiplyMatrix(hiddenSlope.columnSlice(offset, offset + width));
+            for(int i = 0; i < DJdb1.getRows(); i++)
+            {
+                const double* source = modelDJdb1.rowPointer(i);
+                double* target = DJdb1.rowPointer(i) + offset;
+                for(int j = 0; j < width; j++)
+                {
+                    target[j] = rate * source[j];
+                }
+            }
+
+            Matrix<double> DJdw2 = Matrix<double>::dot(H, DJdb2, true, false);
+            DJdw2.elementWiseMulitpyScalar(rate);
+            this->weights_hidden_output[m] = Matrix<double>::subtract(this->weights_hidden_output[m], DJdw2);
+            double* outputBias = this->biasOutput[m].rowPointer(0);
+            for(int i = 0; i < DJdb2.getRows(); i++)
+            {
+                const double* gradient = DJdb2.rowPointer(i);
+                for(int j = 0; j < this->outputNodes; j++)
+                {
+                    outputBias[j] -= rate * gradient[j];
+                }
+            }
+        }
+
+        // grouped input layer update, weights -= transpose(batch) * DJdb1 for all models at once
+        double* hiddenBias = this->biasHidden.rowPointer(0);
+        for(int i = 0; i < batch.getRows(); i++)
+        {
+            const double* x = batch.rowPointer(i);
+            const double* gradient = DJdb1.rowPointer(i);
+            for(int j = 0; j < totalHidden; j++)
+            {
+                hiddenBias[j] -= gradient[j];
+            }
+            for(int k = 0; k < this->inputNodes; k++)
+            {
+                const double xk = x[k];
+                if(xk == 0) continue;
+                double* weights = this->weights_input_hidden.rowPointer(k);
+                for(int j = 0; j < totalHidden; j++)
+                {
+                    weights[j] -= xk * gradient[j];
+                }
+            }
+        }
+    }
+    for(int m = 0; m < models(); m++)
+    {
+        results[m].config = this->configs[m];
+    }
+    finishResults(results);
+    return results;
+}
+/*!
+ * @details Loss and accuracy of every model on inputs, sharing one grouped GEMM per batch for the input layers.
+ * @return One SweepResult per model.
+ */
+std::vector<SweepResult> SweepRunner::evaluate(const Matrix<double>& inputs, const std::vector<int>& labels, int batchSize) const
+{
+    validateData(inputs, labels, batchSize);
+    std::function<double (double)> sigmoidFunction = NeuralNet::returnSigmoidFunction();
+    std::vector<SweepResult> results(this->configs.size(), SweepResult());
+    for(int begin = 0; begin < inputs.getRows(); begin += batchSize)
+    {
+        const int end = std::min(inputs.getRows(), begin + batchSize);
+        Matrix<double> hidden = hiddenSum(inputs.rowSlice(begin, end));
+        hidden.map(sigmoidFunction);
+        for(int m = 0; m < models(); m++)
+        {
+            const int offset = this->hiddenOffset[m];
+            Matrix<double> H = hidden.columnSlice(offset, offset + this->configs[m].hiddenNodes);
+            Matrix<double> Y = Matrix<double>::dot(H, this->weights_hidden_output[m]);
+            Y.addRowVector(this->biasOutput[m]);
+            Y.map(sigmoidFunction);
+            scoreOutputs(results[m], Y, labels, begin);
+        }
+    }
+    for(int m = 0; m < models(); m++)
+    {
+        results[m].config = this->configs[m];
+    }
+    finishResults(results);
+    return results;
+}
+/*!
+ * @details Copies model index out of the sweep as a standalone NeuralNet using SGD at the model's rate. Throws
+ * std::out_of_range if index is not a model.
+ */
+NeuralNet SweepRunner::model(int index) const
+{
+    if(index < 0 || index >= models()) throw std::out_of_range("Sweep model out of range");
+    const int offset = this->hiddenOffset[index];
+    const int width = this->configs[index].hiddenNodes;
+    NeuralNet net(this->weights_input_hidden.columnSlice(offset, offset + width), this->weights_hidden_output[index],
+                  this->biasHidden.columnSlice(offset, offset + width), this->biasOutput[index]);
+    net.setLearningRate(this->configs[index].learningRate);
+    return net;
+}